@@ -0,0 +1,180 @@
+#include "BigFloat.h"
+#include "FloatExp.h"
+
+#include <cmath>
+#include <cstdlib>
+
+int BigFloat::compareMagnitude(const BigFloat& a, const BigFloat& b) {
+	for (size_t i{ a.limbs.size() }; i-- > 0;) {
+		if (a.limbs[i] != b.limbs[i])
+			return a.limbs[i] < b.limbs[i] ? -1 : 1;
+	}
+	return 0;
+}
+
+BigFloat BigFloat::addMagnitude(const BigFloat& a, const BigFloat& b, const bool negative) {
+	BigFloat result{ a.limbs.size() };
+	unsigned long long carry{ 0 };
+
+	for (size_t i{ 0 }; i < a.limbs.size(); ++i) {
+		carry += (unsigned long long)a.limbs[i] + b.limbs[i];
+		result.limbs[i] = (unsigned int)carry;
+		carry >>= 32;
+	}
+
+	result.negative = negative;
+	return result;
+}
+
+/* |a| - |b|, requires |a| >= |b| */
+BigFloat BigFloat::subMagnitude(const BigFloat& a, const BigFloat& b, const bool negative) {
+	BigFloat result{ a.limbs.size() };
+	long long borrow{ 0 };
+
+	for (size_t i{ 0 }; i < a.limbs.size(); ++i) {
+		long long diff{ (long long)a.limbs[i] - b.limbs[i] - borrow };
+		borrow = diff < 0;
+		if (borrow)
+			diff += 1LL << 32;
+		result.limbs[i] = (unsigned int)diff;
+	}
+
+	result.negative = negative;
+	return result;
+}
+
+BigFloat BigFloat::fromDouble(const double value, const size_t numLimbs) {
+	BigFloat result{ numLimbs };
+	result.negative = value < 0;
+
+	// Peel off 32 bits at a time, exact since every step only drops the integer part
+	double rest{ std::fabs(value) };
+	for (size_t i{ numLimbs }; i-- > 0 && rest != 0;) {
+		const double limb{ std::floor(rest) };
+		result.limbs[i] = (unsigned int)limb;
+		rest = (rest - limb) * 4294967296.0;
+	}
+
+	return result;
+}
+
+BigFloat BigFloat::fromFloatExp(const FloatExp& value, const size_t numLimbs) {
+	BigFloat result{ numLimbs };
+	result.negative = value.mantissa < 0;
+
+	// Bit j of the 53 bit integer mantissa weighs 2^(exponent - 52 + j), bits outside the limbs are dropped
+	const unsigned long long bits{ (unsigned long long)std::ldexp(std::fabs(value.mantissa), 52) };
+	for (int j{ 0 }; j < 53; ++j) {
+		const long long position{ value.exponent - 52 + j + 32 * (long long)(numLimbs - 1) };
+		if (((bits >> j) & 1) && position >= 0 && position < 32 * (long long)numLimbs)
+			result.limbs[position / 32] |= 1u << (position % 32);
+	}
+
+	return result;
+}
+
+BigFloat BigFloat::fromString(const std::string& text, const size_t numLimbs) {
+	BigFloat result{ numLimbs };
+	std::string digits;
+	int point{ -1 };
+	size_t pos{ 0 };
+
+	if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+		result.negative = text[pos++] == '-';
+
+	for (; pos < text.size(); ++pos) {
+		const char ch{ text[pos] };
+		if (ch >= '0' && ch <= '9')
+			digits += ch;
+		else if (ch == '.')
+			point = (int)digits.size();
+		else
+			break;
+	}
+
+	if (point < 0)
+		point = (int)digits.size();
+
+	if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E'))
+		point += atoi(text.c_str() + pos + 1);
+
+	// Pad so the decimal point lies within the digits
+	if (point < 0) {
+		digits.insert(0, -point, '0');
+		point = 0;
+	}
+	if (point > (int)digits.size())
+		digits.append(point - digits.size(), '0');
+
+	// Integer part
+	unsigned long long integer{ 0 };
+	for (int i{ 0 }; i < point; ++i)
+		integer = integer * 10 + (digits[i] - '0');
+	result.limbs.back() = (unsigned int)integer;
+
+	// Fraction, Horner from the last digit: f = (digit + f) / 10
+	for (size_t i{ digits.size() }; i-- > (size_t)point;) {
+		unsigned long long remainder{ (unsigned long long)(digits[i] - '0') };
+		for (size_t l{ numLimbs - 1 }; l-- > 0;) {
+			const unsigned long long current{ (remainder << 32) | result.limbs[l] };
+			result.limbs[l] = (unsigned int)(current / 10);
+			remainder = current % 10;
+		}
+	}
+
+	return result;
+}
+
+double BigFloat::toDouble() const {
+	double value{ 0 };
+	double scale{ 1 };
+
+	for (size_t i{ limbs.size() }; i-- > 0;) {
+		value += limbs[i] * scale;
+		scale /= 4294967296.0;
+	}
+
+	return negative ? -value : value;
+}
+
+BigFloat BigFloat::operator+(const BigFloat& other) const {
+	if (negative == other.negative)
+		return addMagnitude(*this, other, negative);
+
+	if (compareMagnitude(*this, other) >= 0)
+		return subMagnitude(*this, other, negative);
+
+	return subMagnitude(other, *this, other.negative);
+}
+
+BigFloat BigFloat::operator-(const BigFloat& other) const {
+	BigFloat negated{ other };
+	negated.negative = !other.negative;
+	return *this + negated;
+}
+
+BigFloat BigFloat::operator*(const BigFloat& other) const {
+	const size_t n{ limbs.size() };
+	std::vector<unsigned int> product(2 * n, 0);
+
+	for (size_t i{ 0 }; i < n; ++i) {
+		if (limbs[i] == 0)
+			continue;
+
+		unsigned long long carry{ 0 };
+		for (size_t j{ 0 }; j < n; ++j) {
+			carry += (unsigned long long)limbs[i] * other.limbs[j] + product[i + j];
+			product[i + j] = (unsigned int)carry;
+			carry >>= 32;
+		}
+		product[i + n] = (unsigned int)carry;
+	}
+
+	// Both operands carry n - 1 fraction limbs, so the product carries 2n - 2 of them
+	BigFloat result{ n };
+	for (size_t i{ 0 }; i < n; ++i)
+		result.limbs[i] = product[i + n - 1];
+
+	result.negative = negative != other.negative;
+	return result;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct FloatExp;
+
+/*
+	Fixed point number for reference orbits: sign and magnitude, 32 bit limbs stored little endian.
+	The most significant limb is the integer part, all others are fraction, so values have to stay
+	below 2^32 which escape time orbits always do. Products are truncated to the operands' length.
+*/
+class BigFloat {
+private:
+	bool negative{ false };
+	std::vector<unsigned int> limbs;
+
+	static int compareMagnitude(const BigFloat& a, const BigFloat& b);
+	static BigFloat addMagnitude(const BigFloat& a, const BigFloat& b, const bool negative);
+	static BigFloat subMagnitude(const BigFloat& a, const BigFloat& b, const bool negative);
+
+public:
+	explicit BigFloat(const size_t numLimbs)
+		:limbs(numLimbs, 0)
+	{
+	}
+
+	static BigFloat fromDouble(const double value, const size_t numLimbs);
+	static BigFloat fromFloatExp(const FloatExp& value, const size_t numLimbs);
+
+	/* Decimal notation like "-0.0452407413040912345678" or "1.5e-40" */
+	static BigFloat fromString(const std::string& text, const size_t numLimbs);
+
+	double toDouble() const;
+
+	BigFloat operator+(const BigFloat& other) const;
+	BigFloat operator-(const BigFloat& other) const;
+	BigFloat operator*(const BigFloat& other) const;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <intrin.h>
+
+/* Instruction sets the kernels can use */
+struct CPUFeatures {
+	bool sse2{ false };
+	bool avx2{ false };
+	bool fma{ false };
+	bool avx512f{ false };
+};
+
+/* Probes CPUID, AVX and AVX-512 also need the OS to save the wider registers (XCR0) */
+static CPUFeatures detectCPUFeatures() {
+	CPUFeatures features;
+	int info[4];
+
+	__cpuid(info, 0);
+	const int maxLeaf{ info[0] };
+
+	__cpuid(info, 1);
+	features.sse2 = (info[3] & (1 << 26)) != 0;
+	const bool fma{ (info[2] & (1 << 12)) != 0 };
+	const bool osxsave{ (info[2] & (1 << 27)) != 0 };
+
+	const unsigned long long xcr0{ osxsave ? _xgetbv(0) : 0 };
+	const bool osAVX{ (xcr0 & 0x06) == 0x06 };
+	const bool osAVX512{ (xcr0 & 0xE6) == 0xE6 };
+
+	features.fma = osAVX && fma;
+
+	if (maxLeaf >= 7) {
+		__cpuidex(info, 7, 0);
+		features.avx2 = osAVX && (info[1] & (1 << 5)) != 0;
+		features.avx512f = osAVX512 && (info[1] & (1 << 16)) != 0;
+	}
+
+	return features;
+}
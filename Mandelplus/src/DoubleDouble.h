@@ -0,0 +1,141 @@
+#pragma once
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+/*
+	Unevaluated sum hi + lo of two doubles with |lo| <= ulp(hi) / 2, about 106 bits of mantissa.
+	Algorithms from Hida, Li, Bailey: Library for Double-Double and Quad-Double Arithmetic.
+	They rely on strict IEEE evaluation, so the translation units using them must not be built with /fp:fast.
+*/
+struct DoubleDouble {
+	double hi, lo;
+};
+
+/* s + e == a + b exactly */
+static inline double twoSum(const double a, const double b, double& e) {
+	const double s{ a + b };
+	const double bb{ s - a };
+	e = (a - (s - bb)) + (b - bb);
+	return s;
+}
+
+/* Same as twoSum, requires |a| >= |b| */
+static inline double quickTwoSum(const double a, const double b, double& e) {
+	const double s{ a + b };
+	e = b - (s - a);
+	return s;
+}
+
+/* p + e == a * b exactly, with a hardware FMA if the compiler guarantees one, Dekker's split otherwise */
+static inline double twoProd(const double a, const double b, double& e) {
+	const double p{ a * b };
+#ifdef FP_FAST_FMA
+	e = std::fma(a, b, -p);
+#else
+	const double split{ 134217729.0 }; // 2^27 + 1
+	const double ta{ split * a };
+	const double aHi{ ta - (ta - a) };
+	const double aLo{ a - aHi };
+	const double tb{ split * b };
+	const double bHi{ tb - (tb - b) };
+	const double bLo{ b - bHi };
+	e = ((aHi * bHi - p) + aHi * bLo + aLo * bHi) + aLo * bLo;
+#endif
+	return p;
+}
+
+static inline DoubleDouble ddAdd(const DoubleDouble a, const DoubleDouble b) {
+	double e, f;
+	double s{ twoSum(a.hi, b.hi, e) };
+	const double t{ twoSum(a.lo, b.lo, f) };
+	e += t;
+	s = quickTwoSum(s, e, e);
+	e += f;
+	s = quickTwoSum(s, e, e);
+	return DoubleDouble{ s, e };
+}
+
+static inline DoubleDouble ddAdd(const DoubleDouble a, const double b) {
+	double e;
+	double s{ twoSum(a.hi, b, e) };
+	e += a.lo;
+	s = quickTwoSum(s, e, e);
+	return DoubleDouble{ s, e };
+}
+
+static inline DoubleDouble ddNeg(const DoubleDouble a) {
+	return DoubleDouble{ -a.hi, -a.lo };
+}
+
+static inline DoubleDouble ddMul(const DoubleDouble a, const DoubleDouble b) {
+	double e;
+	double p{ twoProd(a.hi, b.hi, e) };
+	e += a.hi * b.lo + a.lo * b.hi;
+	p = quickTwoSum(p, e, e);
+	return DoubleDouble{ p, e };
+}
+
+static inline DoubleDouble ddMul(const DoubleDouble a, const double b) {
+	double e;
+	double p{ twoProd(a.hi, b, e) };
+	e += a.lo * b;
+	p = quickTwoSum(p, e, e);
+	return DoubleDouble{ p, e };
+}
+
+static inline DoubleDouble ddSqr(const DoubleDouble a) {
+	double e;
+	double p{ twoProd(a.hi, a.hi, e) };
+	e += 2 * a.hi * a.lo;
+	p = quickTwoSum(p, e, e);
+	return DoubleDouble{ p, e };
+}
+
+static inline DoubleDouble ddDiv(const DoubleDouble a, const double b) {
+	// One correction step of the long division is enough for 106 bits
+	const double q1{ a.hi / b };
+	const DoubleDouble r{ ddAdd(a, ddNeg(ddMul(DoubleDouble{ b, 0 }, q1))) };
+	const double q2{ r.hi / b };
+	double e;
+	const double q{ quickTwoSum(q1, q2, e) };
+	return DoubleDouble{ q, e };
+}
+
+/* Parses decimal numbers like "-0.0452407413040912345678e-3", digits beyond double precision are kept */
+static inline DoubleDouble parseDoubleDouble(const std::string& text) {
+	DoubleDouble value{ 0, 0 };
+	int exponent{ 0 };
+	bool negative{ false };
+	bool fraction{ false };
+	size_t pos{ 0 };
+
+	if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+		negative = text[pos++] == '-';
+
+	for (; pos < text.size(); ++pos) {
+		const char ch{ text[pos] };
+		if (ch >= '0' && ch <= '9') {
+			value = ddAdd(ddMul(value, 10.0), (double)(ch - '0'));
+			if (fraction)
+				exponent--;
+		}
+		else if (ch == '.') {
+			fraction = true;
+		}
+		else if (ch == 'e' || ch == 'E') {
+			exponent += atoi(text.c_str() + pos + 1);
+			break;
+		}
+		else {
+			break;
+		}
+	}
+
+	for (; exponent > 0; exponent--)
+		value = ddMul(value, 10.0);
+	for (; exponent < 0; exponent++)
+		value = ddDiv(value, 10.0);
+
+	return negative ? ddNeg(value) : value;
+}
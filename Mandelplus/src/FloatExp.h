@@ -0,0 +1,167 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/*
+	mantissa * 2^exponent with the mantissa in [1, 2) or 0, for deltas below the 1e-308 a double can hold.
+	Operations avoid branches and library calls, only bit manipulation and selects, so loops over them vectorize.
+*/
+struct FloatExp {
+	double mantissa;
+	long long exponent;
+
+	/* Exponent of 0, low enough to lose every addition and stay far from overflowing when multiplied */
+	static const long long zeroExponent{ -(1LL << 60) };
+
+	FloatExp()
+		:mantissa{ 0 }, exponent{ zeroExponent }
+	{
+	}
+
+	FloatExp(const double mantissa, const long long exponent)
+		:mantissa{ mantissa }, exponent{ exponent }
+	{
+	}
+
+	/* Brings the mantissa back into [1, 2) by moving its binary exponent over */
+	static FloatExp normalize(const double mantissa, const long long exponent) {
+		uint64_t bits;
+		std::memcpy(&bits, &mantissa, sizeof(bits));
+
+		const long long biased{ (long long)((bits >> 52) & 0x7ff) };
+		bits = (bits & ~(0x7ffULL << 52)) | (1023ULL << 52);
+
+		double normalized;
+		std::memcpy(&normalized, &bits, sizeof(normalized));
+
+		// Mantissas come from products and sums of normalized ones, so a zero field means 0 and never a subnormal
+		const bool zero{ biased == 0 };
+		return FloatExp{ zero ? 0.0 : normalized, zero ? zeroExponent : exponent + biased - 1023 };
+	}
+
+	/* 2^exponent for exponents the double range covers, 0 below it */
+	static double powerOfTwo(const long long exponent) {
+		const uint64_t bits{ (uint64_t)(exponent + 1023) << 52 };
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	explicit FloatExp(const double value) {
+		*this = normalize(value, 0);
+	}
+
+	double toDouble() const {
+		if (exponent < -1074)
+			return 0;
+		if (exponent > 1023)
+			return mantissa * HUGE_VAL;
+		return std::ldexp(mantissa, (int)exponent);
+	}
+
+	/* log2 of the magnitude, -inf for 0 */
+	double log2() const {
+		return mantissa == 0 ? -HUGE_VAL : exponent + std::log2(std::fabs(mantissa));
+	}
+};
+
+static inline FloatExp operator*(const FloatExp a, const FloatExp b) {
+	return FloatExp::normalize(a.mantissa * b.mantissa, a.exponent + b.exponent);
+}
+
+static inline FloatExp operator*(const FloatExp a, const double b) {
+	return a * FloatExp{ b };
+}
+
+static inline FloatExp operator*(const double a, const FloatExp b) {
+	return FloatExp{ a } * b;
+}
+
+static inline FloatExp operator+(const FloatExp a, const FloatExp b) {
+	// Scale the smaller one down to the bigger one's exponent, past 1023 bits of difference it is exactly 0
+	const bool aBigger{ a.exponent >= b.exponent };
+	const FloatExp big{ aBigger ? a : b };
+	const FloatExp small{ aBigger ? b : a };
+	const long long difference{ big.exponent - small.exponent };
+	const double scale{ FloatExp::powerOfTwo(-(difference < 1023 ? difference : 1023)) };
+	return FloatExp::normalize(big.mantissa + small.mantissa * scale, big.exponent);
+}
+
+static inline FloatExp operator-(const FloatExp a) {
+	return FloatExp{ -a.mantissa, a.exponent };
+}
+
+static inline FloatExp operator-(const FloatExp a, const FloatExp b) {
+	return a + (-b);
+}
+
+static inline FloatExp operator+(const FloatExp a, const double b) {
+	return a + FloatExp{ b };
+}
+
+static inline bool operator<(const FloatExp a, const FloatExp b) {
+	return (a - b).mantissa < 0;
+}
+
+static inline bool operator<=(const FloatExp a, const FloatExp b) {
+	return (a - b).mantissa <= 0;
+}
+
+static inline FloatExp sqrt(const FloatExp a) {
+	// Even exponents halve exactly, an odd one moves a factor 2 into the mantissa
+	const long long odd{ a.exponent & 1 };
+	return FloatExp::normalize(std::sqrt(a.mantissa * (odd ? 2.0 : 1.0)), (a.exponent - odd) / 2);
+}
+
+static inline FloatExp hypot(const FloatExp a, const FloatExp b) {
+	return sqrt(a * a + b * b);
+}
+
+/* Lets code templated on the delta type read FloatExp members */
+static inline double toDouble(const double value) {
+	return value;
+}
+
+static inline double toDouble(const FloatExp value) {
+	return value.toDouble();
+}
+
+template <typename T>
+T fromFloatExp(const FloatExp value);
+
+template <>
+inline double fromFloatExp<double>(const FloatExp value) {
+	return value.toDouble();
+}
+
+template <>
+inline FloatExp fromFloatExp<FloatExp>(const FloatExp value) {
+	return value;
+}
+
+/* Parses decimal numbers like "1.5e-500" whose exponent a double cannot hold */
+static inline FloatExp parseFloatExp(const std::string& text) {
+
+	// Within the double range strtod rounds best
+	const double value{ std::strtod(text.c_str(), nullptr) };
+	if (std::fabs(value) >= 1e-300 && std::fabs(value) <= 1e300)
+		return FloatExp{ value };
+
+	const size_t e{ text.find_first_of("eE") };
+	const FloatExp mantissa{ std::strtod(text.substr(0, e).c_str(), nullptr) };
+	long long power{ e == std::string::npos ? 0 : std::atoll(text.c_str() + e + 1) };
+
+	// 10^|power| by squaring
+	FloatExp scale{ 1.0 };
+	FloatExp base{ power < 0 ? 0.1 : 10.0 };
+	for (power = power < 0 ? -power : power; power > 0; power >>= 1) {
+		if (power & 1)
+			scale = scale * base;
+		base = base * base;
+	}
+
+	return mantissa * scale;
+}
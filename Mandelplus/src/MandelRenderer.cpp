@@ -1,44 +1,781 @@
 #include "MandelRenderer.h"
 
+#include <complex>
+
 Color MandelbrotRenderer::getColor(const int i, const double r, const double c) {
 	const double size{ sqrt(r * r + c * c) };
-	const double smoothed{ log(log(size) * ONE_OVER_LOG2) * ONE_OVER_LOG2 };
+	const double smoothed{ log(log(size) * ONE_OVER_LOG2 * smoothingScale) * ONE_OVER_LOG2 };
 	const int colorI{ (int)(sqrt(i + 1 - smoothed) * 256) % 512 };
-	unsigned int cr, cg, cb;
-	sscanf_s(hex[colorI].c_str(), "%02x%02x%02x", &cr, &cg, &cb);
-	return Color{ (cr),(cg),(cb) };
+	return palette[colorI];
+}
+
+/* Smooth coloring darkened within a few pixels of the set, which outlines filaments too thin to hit a pixel.
+   With interior estimation the interior gets a color per atom domain, darkened towards the boundary the same way */
+Color MandelbrotRenderer::getDistanceColor(const ManVal& value, const double distance, const unsigned int atom) {
+	const bool interior{ value.i >= maxIterations };
+	if (interior && distance == 0)
+		return Color{ 0, 0, 0 };
+
+	const Color color{ interior ? palette[(atom * 97) % 512] : getColor(value.i, value.r, value.c) };
+	if (!interior && !distanceEstimation)
+		return color;
+
+	const double spacing{ 2 * zoom / std::max(width, height) };
+	const double shade{ std::min(1.0, std::sqrt(distance / (4 * spacing))) };
+	return Color{ (unsigned int)(color.r * shade), (unsigned int)(color.g * shade), (unsigned int)(color.b * shade) };
+}
+
+void MandelbrotRenderer::setKernel(const Kernel kernel) {
+	bool supported{ false };
+
+	switch (kernel) {
+	case Kernel::Scalar:
+		supported = true;
+		break;
+	case Kernel::SSE2:
+		supported = cpu.sse2;
+		break;
+	case Kernel::AVX2:
+		supported = cpu.avx2 && cpu.fma;
+		break;
+	case Kernel::AVX512:
+		supported = cpu.avx512f;
+		break;
+	default:
+		break;
+	}
+
+	if (supported) {
+		this->kernel = kernel;
+		return;
+	}
+
+	if (kernel != Kernel::Auto)
+		std::cout << "Requested kernel is not supported by this CPU, selecting automatically" << std::endl;
+
+	if (cpu.avx512f)
+		this->kernel = Kernel::AVX512;
+	else if (cpu.avx2 && cpu.fma)
+		this->kernel = Kernel::AVX2;
+	else if (cpu.sse2)
+		this->kernel = Kernel::SSE2;
+	else
+		this->kernel = Kernel::Scalar;
+}
+
+const char* MandelbrotRenderer::getKernelName() const {
+	switch (kernel) {
+	case Kernel::SSE2:
+		return "SSE2";
+	case Kernel::AVX2:
+		return "AVX2";
+	case Kernel::AVX512:
+		return "AVX-512";
+	default:
+		return "Scalar";
+	}
+}
+
+const char* MandelbrotRenderer::getPrecisionName() const {
+	switch (activePrecision) {
+	case Precision::Float:
+		return "Float";
+	case Precision::DoubleDouble:
+		return "DoubleDouble";
+	case Precision::Perturbation:
+		return "Perturbation";
+	case Precision::SeriesApproximation:
+		return "SeriesApproximation";
+	case Precision::BLA:
+		return "BLA";
+	default:
+		return "Double";
+	}
 }
 
-ManVal MandelbrotRenderer::getMandelbrotValue(const int x, const int y) {
+Precision MandelbrotRenderer::selectPrecision() const {
+
+	// Closest pixels are this far apart
+	const FloatExp spacing{ extendedZoom * (2.0 / std::max(width, height)) };
+
+	// Orbits reach |z| = 2 before they escape, so the iteration never gets away with less than that
+	const double magnitude{ std::max({ 2.0, std::fabs(dx) + zoom, std::fabs(dy) + zoom }) };
+
+	// Mantissa bits needed to tell neighbouring pixels apart
+	const double bits{ std::log2(magnitude) - spacing.log2() + guardBits };
+
+	if (bits <= 24)
+		return Precision::Float;
+	if (bits <= 53)
+		return Precision::Double;
+	if (bits <= 106)
+		return Precision::DoubleDouble;
+
+	// Only perturbation goes deeper, BLA pays for its table once orbits get long
+	return maxIterations >= 100000 ? Precision::BLA : Precision::SeriesApproximation;
+}
+
+ManVal MandelbrotRenderer::getMandelbrotValue(const int x, const int y, unsigned int& interior, double& distance) {
 
 	// Map pixel position between minR and maxR
 	double a{ map(x, 0, width, -zoom, zoom) + dx };
 	double b{ map(y, 0, height, -zoom, zoom) + dy };
 
+	const unsigned int period{ interiorPeriod(a, b) };
+	if (period != 0) {
+		interior++;
+		return ManVal{ 0, 0, maxIterations, period };
+	}
+
 	const double initialA{ a };
 	const double initialB{ b };
 
+	// Brent's cycle detection, the orbit is saved whenever the iteration count reaches a power of 2
+	double savedA{ a };
+	double savedB{ b };
+	unsigned int savedN{ 0 };
+	unsigned long long checkpoint{ 1 };
+
+	// dz/dc for the distance estimate, z starts at c
+	double da{ 1 };
+	double db{ 0 };
+
+	// Squares of z, the ones of the escape test are reused by the next iteration
+	double aa{ a * a };
+	double bb{ b * b };
+
 	unsigned int n{ 0 };
 
 	// Iterate
 	for (n = 0; n < maxIterations; n++) {
+		if (trackDerivative) {
+			const double newDa{ 2 * (a * da - b * db) + 1 };
+			db = 2 * (a * db + b * da);
+			da = newDa;
+		}
+
 		// Apply mandelbrot formula
-		double newA{ a * a - b * b };
+		double newA{ aa - bb };
 
 		double newB{ 2 * a*b };
 
 		a = initialA + newA;
 		b = initialB + newB;
 
+		aa = a * a;
+		bb = b * b;
+
 		// If it gets towards infinity
-		if (abs(a + b) > 2)
+		if (aa + bb > bailoutSquared)
 			break;
+
+		if (!periodicityChecking)
+			continue;
+
+		// Back at the saved point, so it cycles forever
+		const double distA{ a - savedA };
+		const double distB{ b - savedB };
+		if (distA * distA + distB * distB < periodTolerance)
+			return ManVal{ a, b, maxIterations, n + 1 - savedN };
+
+		if (n + 1 == checkpoint) {
+			savedA = a;
+			savedB = b;
+			savedN = n + 1;
+			checkpoint *= 2;
+		}
 	}
 
+	if (trackDerivative && n < maxIterations)
+		distance = distanceEstimate(a, b, da, db, initialA, initialB);
+
 	return ManVal{ a,b,n };
 
 }
 
+ManVal MandelbrotRenderer::getMandelbrotValueFloat(const int x, const int y, unsigned int& interior, double& distance) {
+
+	// Only the iteration runs in float, the pixel is mapped in double
+	const double mappedA{ map(x, 0, width, -zoom, zoom) + dx };
+	const double mappedB{ map(y, 0, height, -zoom, zoom) + dy };
+
+	const unsigned int period{ interiorPeriod(mappedA, mappedB) };
+	if (period != 0) {
+		interior++;
+		return ManVal{ 0, 0, maxIterations, period };
+	}
+
+	float a{ (float)mappedA };
+	float b{ (float)mappedB };
+
+	const float initialA{ a };
+	const float initialB{ b };
+
+	float savedA{ a };
+	float savedB{ b };
+	unsigned int savedN{ 0 };
+	unsigned long long checkpoint{ 1 };
+
+	float da{ 1 };
+	float db{ 0 };
+
+	const float bailoutSquaredFloat{ (float)bailoutSquared };
+	float aa{ a * a };
+	float bb{ b * b };
+
+	unsigned int n{ 0 };
+
+	// Iterate
+	for (n = 0; n < maxIterations; n++) {
+		if (trackDerivative) {
+			const float newDa{ 2 * (a * da - b * db) + 1 };
+			db = 2 * (a * db + b * da);
+			da = newDa;
+		}
+
+		const float newA{ aa - bb };
+		const float newB{ 2 * a * b };
+
+		a = initialA + newA;
+		b = initialB + newB;
+
+		aa = a * a;
+		bb = b * b;
+
+		// If it gets towards infinity
+		if (aa + bb > bailoutSquaredFloat)
+			break;
+
+		if (!periodicityChecking)
+			continue;
+
+		const float distA{ a - savedA };
+		const float distB{ b - savedB };
+		if (distA * distA + distB * distB < periodToleranceFloat)
+			return ManVal{ a, b, maxIterations, n + 1 - savedN };
+
+		if (n + 1 == checkpoint) {
+			savedA = a;
+			savedB = b;
+			savedN = n + 1;
+			checkpoint *= 2;
+		}
+	}
+
+	if (trackDerivative && n < maxIterations)
+		distance = distanceEstimate(a, b, da, db, initialA, initialB);
+
+	return ManVal{ a, b, n };
+}
+
+ManVal MandelbrotRenderer::getMandelbrotValueDD(const int x, const int y) {
+
+	// Offsets from the center are small enough for doubles, the center itself is not
+	const DoubleDouble initialA{ ddAdd(centerX, map(x, 0, width, -zoom, zoom)) };
+	const DoubleDouble initialB{ ddAdd(centerY, map(y, 0, height, -zoom, zoom)) };
+
+	DoubleDouble a{ initialA };
+	DoubleDouble b{ initialB };
+
+	unsigned int n{ 0 };
+
+	// Iterate
+	for (n = 0; n < maxIterations; n++) {
+		// Apply mandelbrot formula
+		const DoubleDouble newA{ ddAdd(ddSqr(a), ddNeg(ddSqr(b))) };
+		const DoubleDouble ab{ ddMul(a, b) };
+		const DoubleDouble newB{ 2 * ab.hi, 2 * ab.lo };
+
+		a = ddAdd(initialA, newA);
+		b = ddAdd(initialB, newB);
+
+		// If it gets towards infinity
+		if (a.hi * a.hi + b.hi * b.hi > bailoutSquared)
+			break;
+	}
+
+	return ManVal{ a.hi, b.hi, n };
+}
+
+template <>
+double MandelbrotRenderer::pixelOffset<double>(const int value, const unsigned int size) const {
+	return map(value, 0, size, -zoom, zoom);
+}
+
+template <>
+FloatExp MandelbrotRenderer::pixelOffset<FloatExp>(const int value, const unsigned int size) const {
+	return extendedZoom * map(value, 0, size, -1, 1);
+}
+
+template <typename T>
+ManVal MandelbrotRenderer::getPerturbedValue(const int x, const int y, bool& glitched, double& ratio) {
+
+	// Offset of the pixel from the reference, T is FloatExp once doubles cannot express it
+	const T initialDeltaA{ pixelOffset<T>(x, width) - fromFloatExp<T>(referenceOffsetA) };
+	const T initialDeltaB{ pixelOffset<T>(y, height) - fromFloatExp<T>(referenceOffsetB) };
+
+	T deltaA{ initialDeltaA };
+	T deltaB{ initialDeltaB };
+
+	// Jump over the iterations the series covers, delta_0 (A + delta_0 (B + delta_0 C)) by Horner
+	if (seriesSkip > 0) {
+		T termA{ fromFloatExp<T>(seriesRe[2]) };
+		T termB{ fromFloatExp<T>(seriesIm[2]) };
+		for (int k{ 1 }; k >= 0; k--) {
+			const T newTermA{ termA * initialDeltaA - termB * initialDeltaB + fromFloatExp<T>(seriesRe[k]) };
+			const T newTermB{ termA * initialDeltaB + termB * initialDeltaA + fromFloatExp<T>(seriesIm[k]) };
+			termA = newTermA;
+			termB = newTermB;
+		}
+		deltaA = termA * initialDeltaA - termB * initialDeltaB;
+		deltaB = termA * initialDeltaB + termB * initialDeltaA;
+	}
+
+	unsigned int n{ seriesSkip };
+
+	double a{ referenceA[n] + toDouble(deltaA) };
+	double b{ referenceB[n] + toDouble(deltaB) };
+
+	const unsigned int referenceLength{ (unsigned int)referenceA.size() };
+
+	glitched = false;
+
+	// Iterate
+	for (; n < maxIterations; n++) {
+
+		// The reference escaped before this pixel, finish in plain double
+		if (n + 1 >= referenceLength) {
+			const double initialA{ dx + toDouble(referenceOffsetA) + toDouble(initialDeltaA) };
+			const double initialB{ dy + toDouble(referenceOffsetB) + toDouble(initialDeltaB) };
+
+			// Past |z| = 2 the orbit is sure to escape and double keeps its relative error small, only the
+			// escape radius was out of the reference's reach
+			const bool escaping{ a * a + b * b > 4 };
+
+			for (; n < maxIterations; n++) {
+				const double newA{ a * a - b * b };
+				const double newB{ 2 * a*b };
+
+				a = initialA + newA;
+				b = initialB + newB;
+
+				if (a * a + b * b > bailoutSquared)
+					break;
+			}
+
+			// Only exact if the pixel escapes shortly after the reference, a longer living reference fixes it
+			glitched = glitchCorrection && !escaping;
+			ratio = 1;
+			break;
+		}
+
+		// z = Z + delta, so delta' = 2 Z delta + delta^2 + initialDelta
+		const double za{ referenceA[n] };
+		const double zb{ referenceB[n] };
+		const T newDeltaA{ 2 * (za * deltaA - zb * deltaB) + (deltaA * deltaA - deltaB * deltaB) + initialDeltaA };
+		const T newDeltaB{ 2 * (za * deltaB + zb * deltaA) + 2 * deltaA * deltaB + initialDeltaB };
+
+		deltaA = newDeltaA;
+		deltaB = newDeltaB;
+
+		const double nextA{ referenceA[n + 1] };
+		const double nextB{ referenceB[n + 1] };
+		a = nextA + toDouble(deltaA);
+		b = nextB + toDouble(deltaB);
+
+		// If it gets towards infinity
+		const double size{ a * a + b * b };
+		if (size > bailoutSquared)
+			break;
+
+		// z lost its precision relative to Z
+		const double referenceSize{ nextA * nextA + nextB * nextB };
+		if (glitchCorrection && size < glitchTolerance * referenceSize) {
+			glitched = true;
+			ratio = size / referenceSize;
+			break;
+		}
+	}
+
+	return ManVal{ a, b, n };
+}
+
+void MandelbrotRenderer::computeReferenceOrbit(const FloatExp offsetA, const FloatExp offsetB) {
+
+	// Enough bits to resolve a pixel plus guard bits for the orbit's error growth
+	const size_t numLimbs{ 2 + (size_t)((std::log2(width) - extendedZoom.log2() + 64) / 32) };
+
+	const BigFloat centerA{ centerRe.empty() ? BigFloat::fromDouble(dx, numLimbs) : BigFloat::fromString(centerRe, numLimbs) };
+	const BigFloat centerB{ centerIm.empty() ? BigFloat::fromDouble(dy, numLimbs) : BigFloat::fromString(centerIm, numLimbs) };
+	const BigFloat initialA{ centerA + BigFloat::fromFloatExp(offsetA, numLimbs) };
+	const BigFloat initialB{ centerB + BigFloat::fromFloatExp(offsetB, numLimbs) };
+
+	BigFloat a{ initialA };
+	BigFloat b{ initialB };
+
+	referenceOffsetA = offsetA;
+	referenceOffsetB = offsetB;
+	seriesSkip = 0;
+	referenceA.clear();
+	referenceB.clear();
+	referenceA.push_back(a.toDouble());
+	referenceB.push_back(b.toDouble());
+
+	for (unsigned int n{ 0 }; n < maxIterations; n++) {
+		const BigFloat ab{ a * b };
+		a = a * a - b * b + initialA;
+		b = ab + ab + initialB;
+
+		const double za{ a.toDouble() };
+		const double zb{ b.toDouble() };
+		referenceA.push_back(za);
+		referenceB.push_back(zb);
+
+		// Stop with the same test the pixels use, past it the orbit diverges and is no use as a reference.
+		// BigFloat only holds values below 2^32, so it stops at |Z| = 2^15 if the bailout lies beyond
+		if (za * za + zb * zb > std::min(bailoutSquared, referenceBailoutSquared))
+			break;
+	}
+
+	stats.references++;
+}
+
+template <typename T>
+void MandelbrotRenderer::computeSeries() {
+
+	// The corner pixels lie farthest from the center, their error bounds everyone's
+	const T radius{ fromFloatExp<T>(extendedZoom) * std::sqrt(2.0) };
+	const unsigned int referenceLength{ (unsigned int)referenceA.size() };
+
+	// A_0 = 1, B_0 = C_0 = 0 reproduces delta_0
+	T aRe{ 1.0 }, aIm{ 0.0 };
+	T bRe{ 0.0 }, bIm{ 0.0 };
+	T cRe{ 0.0 }, cIm{ 0.0 };
+
+	seriesSkip = 0;
+
+	// Pixels have to take at least one step of their own before the reference ends
+	for (unsigned int n{ 0 }; n + 2 < referenceLength; n++) {
+		const double za{ referenceA[n] };
+		const double zb{ referenceB[n] };
+
+		// Inserting the series into delta' = 2 Z delta + delta^2 + delta_0 and comparing powers of delta_0:
+		// A' = 2 Z A + 1, B' = 2 Z B + A^2, C' = 2 Z C + 2 A B
+		const T newARe{ 2 * (za * aRe - zb * aIm) + 1 };
+		const T newAIm{ 2 * (za * aIm + zb * aRe) };
+		const T newBRe{ 2 * (za * bRe - zb * bIm) + (aRe * aRe - aIm * aIm) };
+		const T newBIm{ 2 * (za * bIm + zb * bRe) + 2 * aRe * aIm };
+		const T newCRe{ 2 * (za * cRe - zb * cIm) + 2 * (aRe * bRe - aIm * bIm) };
+		const T newCIm{ 2 * (za * cIm + zb * cRe) + 2 * (aRe * bIm + aIm * bRe) };
+
+		// The terms left out grow like the cubic one, stop once it is no longer negligible next to the linear one.
+		// Written so an overflow to inf or nan stops as well
+		using std::hypot;
+		const T linear{ hypot(newARe, newAIm) * radius };
+		const T cubic{ hypot(newCRe, newCIm) * radius * radius * radius };
+		if (!(cubic <= seriesTolerance * linear))
+			break;
+
+		aRe = newARe;
+		aIm = newAIm;
+		bRe = newBRe;
+		bIm = newBIm;
+		cRe = newCRe;
+		cIm = newCIm;
+		seriesSkip = n + 1;
+	}
+
+	seriesRe[0] = FloatExp{ aRe };
+	seriesIm[0] = FloatExp{ aIm };
+	seriesRe[1] = FloatExp{ bRe };
+	seriesIm[1] = FloatExp{ bIm };
+	seriesRe[2] = FloatExp{ cRe };
+	seriesIm[2] = FloatExp{ cIm };
+
+	stats.skippedIterations = seriesSkip;
+}
+
+ManVal MandelbrotRenderer::getBLAValue(const int x, const int y) {
+
+	// Always against the view center, rebasing takes the place of glitch correction
+	const double initialDeltaA{ map(x, 0, width, -zoom, zoom) };
+	const double initialDeltaB{ map(y, 0, height, -zoom, zoom) };
+
+	double deltaA{ initialDeltaA };
+	double deltaB{ initialDeltaB };
+
+	double a{ referenceA[0] + deltaA };
+	double b{ referenceB[0] + deltaB };
+
+	const unsigned int referenceLength{ (unsigned int)referenceA.size() };
+
+	// z = Z_m + delta, m restarts at 0 on every rebase while n keeps counting
+	unsigned int m{ 0 };
+	unsigned int n{ 0 };
+
+	while (n < maxIterations) {
+		const double deltaSize{ deltaA * deltaA + deltaB * deltaB };
+
+		// Longest valid step starting at m, levels only start at multiples of their length.
+		// Merged steps are never valid for more than their first single step, so a delta too big
+		// for level 0 goes straight to an exact step
+		const BLAStep* step{ nullptr };
+		unsigned int length{ 1 };
+		if (deltaSize < blaTable[0][m].radius * blaTable[0][m].radius) {
+			for (size_t level{ blaTable.size() }; level-- > 0 && step == nullptr;) {
+				length = 1u << level;
+				if (m % length != 0 || m / length >= blaTable[level].size() || n + length > maxIterations)
+					continue;
+
+				const BLAStep& candidate{ blaTable[level][m / length] };
+				if (deltaSize < candidate.radius * candidate.radius)
+					step = &candidate;
+			}
+		}
+
+		if (step != nullptr) {
+			const double newDeltaA{ step->aRe * deltaA - step->aIm * deltaB + step->bRe * initialDeltaA - step->bIm * initialDeltaB };
+			const double newDeltaB{ step->aRe * deltaB + step->aIm * deltaA + step->bRe * initialDeltaB + step->bIm * initialDeltaA };
+			deltaA = newDeltaA;
+			deltaB = newDeltaB;
+		}
+		else {
+			// delta is too big for any approximation, take one exact perturbation step
+			const double za{ referenceA[m] };
+			const double zb{ referenceB[m] };
+			const double newDeltaA{ 2 * (za * deltaA - zb * deltaB) + (deltaA * deltaA - deltaB * deltaB) + initialDeltaA };
+			const double newDeltaB{ 2 * (za * deltaB + zb * deltaA) + 2 * deltaA * deltaB + initialDeltaB };
+			deltaA = newDeltaA;
+			deltaB = newDeltaB;
+		}
+
+		m += length;
+		n += length;
+
+		a = referenceA[m] + deltaA;
+		b = referenceB[m] + deltaB;
+
+		// If it gets towards infinity
+		if (a * a + b * b > bailoutSquared)
+			return ManVal{ a, b, n - 1 };
+
+		// z came closer to 0 than to Z, or Z ran out: z itself is a delta against the orbit of 0,
+		// whose next point starts the reference again
+		if (n < maxIterations && (a * a + b * b < deltaA * deltaA + deltaB * deltaB || m + 1 >= referenceLength)) {
+			deltaA = a * a - b * b + initialDeltaA;
+			deltaB = 2 * a * b + initialDeltaB;
+			m = 0;
+			n++;
+
+			a = referenceA[0] + deltaA;
+			b = referenceB[0] + deltaB;
+
+			if (a * a + b * b > bailoutSquared)
+				return ManVal{ a, b, n - 1 };
+		}
+	}
+
+	return ManVal{ a, b, n };
+}
+
+void MandelbrotRenderer::computeBLATable() {
+
+	// Below this |delta|^2 vanishes next to |2 Z delta| in double precision
+	const double epsilon{ std::ldexp(1.0, -53) };
+
+	// |delta_0| of the corner pixels bounds everyone's
+	const double initialDeltaSize{ zoom * std::sqrt(2.0) };
+
+	const size_t numSteps{ referenceA.size() - 1 };
+
+	blaTable.clear();
+	blaTable.emplace_back();
+	blaTable[0].reserve(numSteps);
+
+	// One iteration: delta' = 2 Z delta + delta_0 once delta^2 is negligible
+	for (size_t m{ 0 }; m < numSteps; m++) {
+		const double aRe{ 2 * referenceA[m] };
+		const double aIm{ 2 * referenceB[m] };
+		blaTable[0].push_back(BLAStep{ aRe, aIm, 1, 0, epsilon * std::hypot(aRe, aIm) });
+	}
+
+	// Merge neighbouring pairs: first x then y gives A = Ay Ax, B = Ay Bx + By,
+	// and y stays valid as long as the delta x hands over stays below its radius
+	while (blaTable.back().size() > 1) {
+		const std::vector<BLAStep>& previous{ blaTable.back() };
+		std::vector<BLAStep> merged;
+		merged.reserve(previous.size() / 2);
+
+		for (size_t i{ 0 }; i + 1 < previous.size(); i += 2) {
+			const BLAStep& x{ previous[i] };
+			const BLAStep& y{ previous[i + 1] };
+
+			const double sizeAx{ std::hypot(x.aRe, x.aIm) };
+			const double sizeBx{ std::hypot(x.bRe, x.bIm) };
+			const double radiusY{ std::max(0.0, (y.radius - sizeBx * initialDeltaSize) / sizeAx) };
+
+			merged.push_back(BLAStep{
+				y.aRe * x.aRe - y.aIm * x.aIm,
+				y.aRe * x.aIm + y.aIm * x.aRe,
+				y.aRe * x.bRe - y.aIm * x.bIm + y.bRe,
+				y.aRe * x.bIm + y.aIm * x.bRe + y.bIm,
+				std::min(x.radius, radiusY)
+			});
+		}
+
+		blaTable.push_back(std::move(merged));
+	}
+}
+
+/*
+	Interior distance estimate after Albert Lobo's formula, from the attracting cycle of the given period, and the
+	atom domain period, the iteration at which |z| last reached a new minimum. Newton's method refines the orbit
+	point the periodicity check stopped at into an exact point of the cycle.
+*/
+void MandelbrotRenderer::estimateInterior(const unsigned int begin, const unsigned int end, const PixelData data) {
+	typedef std::complex<double> Complex;
+
+	for (unsigned int pixel{ begin }; pixel < end; ++pixel) {
+		const ManVal& value{ data[pixel] };
+		if (value.p == 0)
+			continue;
+
+		const unsigned int period{ value.p };
+		const Complex c{ map(pixel % width, 0, width, -zoom, zoom) + dx, map(pixel / width, 0, height, -zoom, zoom) + dy };
+
+		// interiorPeriod() leaves no orbit point behind, but its cycles have closed forms
+		Complex cycle{ value.r, value.c };
+		if (value.r == 0 && value.c == 0)
+			cycle = period == 1 ? (1.0 - std::sqrt(1.0 - 4.0 * c)) / 2.0 : (-1.0 + std::sqrt(-3.0 - 4.0 * c)) / 2.0;
+
+		for (unsigned int step{ 0 }; step < 16; step++) {
+			Complex z{ cycle };
+			Complex dz{ 1 };
+			for (unsigned int n{ 0 }; n < period; n++) {
+				dz = 2.0 * z * dz;
+				z = z * z + c;
+			}
+
+			const Complex delta{ (z - cycle) / (dz - 1.0) };
+			cycle -= delta;
+			if (std::norm(delta) <= 1e-30 * std::norm(cycle))
+				break;
+		}
+
+		// Derivatives of the period-th iterate at the cycle, by z and c
+		Complex z{ cycle };
+		Complex dz{ 1 };
+		Complex dc{ 0 };
+		Complex dzdz{ 0 };
+		Complex dcdz{ 0 };
+		for (unsigned int n{ 0 }; n < period; n++) {
+			dcdz = 2.0 * (z * dcdz + dz * dc);
+			dzdz = 2.0 * (z * dzdz + dz * dz);
+			dc = 2.0 * z * dc + 1.0;
+			dz = 2.0 * z * dz;
+			z = z * z + c;
+		}
+
+		// A false positive of the periodicity check has no attracting cycle
+		const double multiplier{ std::norm(dz) };
+		const double estimate{ (1 - multiplier) / std::abs(dcdz + dzdz * dc / (1.0 - dz)) };
+		data.setDistance(pixel, multiplier < 1 && estimate > 0 && estimate < INFINITY ? estimate : 0);
+
+		// Once the orbit is caught close to the cycle, one more round of it holds all values still to come,
+		// up to ties closer than that
+		double a{ c.real() };
+		double b{ c.imag() };
+		double smallest{ INFINITY };
+		unsigned int atom{ 0 };
+		unsigned int caught{ maxIterations };
+		for (unsigned int n{ 1 }; n <= maxIterations && n <= caught + period; n++) {
+			const double size{ a * a + b * b };
+			if (size < smallest) {
+				smallest = size;
+				atom = n;
+			}
+
+			const double distA{ a - cycle.real() };
+			const double distB{ b - cycle.imag() };
+			if (caught == maxIterations && distA * distA + distB * distB < 1e-8)
+				caught = n;
+
+			const double newA{ a * a - b * b + c.real() };
+			b = 2 * a * b + c.imag();
+			a = newA;
+		}
+		data.setAtom(pixel, atom);
+	}
+}
+
+void MandelbrotRenderer::perturbGlitches(const std::vector<Glitch>* pending, const size_t begin, const size_t end) {
+	std::vector<Glitch> remaining;
+
+	for (size_t i{ begin }; i < end; ++i) {
+		const unsigned int pixel{ (*pending)[i].pixel };
+		bool glitched;
+		double ratio;
+		data[pixel] = extendedExponent ? getPerturbedValue<FloatExp>(pixel % width, pixel / width, glitched, ratio)
+			: getPerturbedValue<double>(pixel % width, pixel / width, glitched, ratio);
+		if (glitched)
+			remaining.push_back(Glitch{ pixel, ratio });
+	}
+
+	std::lock_guard<std::mutex> lock{ glitchMutex };
+	glitches.insert(glitches.end(), remaining.begin(), remaining.end());
+}
+
+void MandelbrotRenderer::correctGlitches() {
+	const unsigned int numThreads{ threadPool().size() };
+
+	while (!glitches.empty() && stats.references < maxReferences) {
+
+		// The pixel deepest inside a glitch makes the best reference for it,
+		// without real glitches the pixel that outlived the reference the longest
+		Glitch deepest{ glitches[0] };
+		for (const Glitch& g : glitches) {
+			if (g.ratio < deepest.ratio || (g.ratio == deepest.ratio && data[g.pixel].i > data[deepest.pixel].i))
+				deepest = g;
+		}
+
+		const unsigned int x{ deepest.pixel % width };
+		const unsigned int y{ deepest.pixel / width };
+		computeReferenceOrbit(extendedExponent ? pixelOffset<FloatExp>(x, width) : FloatExp{ pixelOffset<double>(x, width) },
+			extendedExponent ? pixelOffset<FloatExp>(y, height) : FloatExp{ pixelOffset<double>(y, height) });
+
+		// Re-render only the glitched pixels against the new reference
+		std::vector<Glitch> pending;
+		pending.swap(glitches);
+
+		const size_t chunk{ (pending.size() + numThreads - 1) / numThreads };
+		const unsigned int numChunks{ (unsigned int)((pending.size() + chunk - 1) / chunk) };
+
+		threadPool().run(numChunks, [&](const unsigned int c) {
+			perturbGlitches(&pending, c * chunk, std::min(c * chunk + chunk, pending.size()));
+		});
+
+		// The reference did not even fix the pixel it was taken from
+		if (glitches.size() == pending.size())
+			break;
+	}
+
+	stats.glitchedPixels = (unsigned int)glitches.size();
+}
+
+void MandelbrotRenderer::setZoom(const std::string& zoom) {
+	extendedZoom = parseFloatExp(zoom);
+	this->zoom = extendedZoom.toDouble();
+}
+
+void MandelbrotRenderer::setCenter(const std::string& re, const std::string& im) {
+	centerRe = re;
+	centerIm = im;
+	centerX = parseDoubleDouble(re);
+	centerY = parseDoubleDouble(im);
+	dx = centerX.hi;
+	dy = centerY.hi;
+}
+
 void  MandelbrotRenderer::exportPPM() const {
 
 	FILE *fp;
@@ -54,26 +791,149 @@ void  MandelbrotRenderer::exportPPM() const {
 	}
 }
 
-void MandelbrotRenderer::construct(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, ManVal* data) {
+bool MandelbrotRenderer::isPerturbedConstruct() const {
+	// The BLA table is in doubles, beyond their range BLA renders as plain perturbation
+	return activePrecision == Precision::Perturbation || activePrecision == Precision::SeriesApproximation || (activePrecision == Precision::BLA && extendedExponent);
+}
+
+/* Appends the pixels that glitched to tileGlitches */
+void MandelbrotRenderer::constructPerturbed(PixelQueue queue, const PixelData data, std::vector<Glitch>& tileGlitches) {
+	unsigned int x, y;
+	while (queue.pop(x, y)) {
+		const unsigned int i{ (x + y * width) };
+		bool glitched;
+		double ratio;
+		data[i] = extendedExponent ? getPerturbedValue<FloatExp>(x, y, glitched, ratio) : getPerturbedValue<double>(x, y, glitched, ratio);
+		if (glitched)
+			tileGlitches.push_back(Glitch{ i, ratio });
+	}
+}
+
+void MandelbrotRenderer::construct(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	constructQueue(PixelQueue::rectangle(minWidth, maxWidth, minHeight, maxHeight), data);
+}
+
+void MandelbrotRenderer::constructQueue(PixelQueue queue, const PixelData data) {
+
+	if (isPerturbedConstruct()) {
+		std::vector<Glitch> tileGlitches;
+		constructPerturbed(queue, data, tileGlitches);
+
+		std::lock_guard<std::mutex> lock{ glitchMutex };
+		glitches.insert(glitches.end(), tileGlitches.begin(), tileGlitches.end());
+		return;
+	}
+
+	if (activePrecision == Precision::BLA) {
+		unsigned int x, y;
+		while (queue.pop(x, y))
+			data[x + y * width] = getBLAValue(x, y);
+		return;
+	}
+
+	if (activePrecision == Precision::Float) {
 
-	for (unsigned int x{ minWidth }; x < maxWidth; x++) {
-		for (unsigned int y{ minHeight }; y < maxHeight; y++) {
-			const unsigned int i{ (x + y * width) };
-			const ManVal v{ getMandelbrotValue(x, y) };
-			data[i] = v;
+		// Lane iteration counters are floats, exact up to 2^24
+		if (maxIterations < (1u << 24)) {
+			switch (kernel) {
+			case Kernel::SSE2:
+				constructFloatSSE2(queue, data);
+				return;
+			case Kernel::AVX2:
+				constructFloatAVX2(queue, data);
+				return;
+			case Kernel::AVX512:
+				constructFloatAVX512(queue, data);
+				return;
+			default:
+				break;
+			}
 		}
+
+		unsigned int x, y, interior{ 0 };
+		while (queue.pop(x, y)) {
+			double distance{ 0 };
+			data[x + y * width] = getMandelbrotValueFloat(x, y, interior, distance);
+			data.setDistance(x + y * width, distance);
+		}
+		interiorPixels.fetch_add(interior, std::memory_order_relaxed);
+		return;
+	}
+
+	if (activePrecision == Precision::DoubleDouble) {
+		switch (kernel) {
+		case Kernel::SSE2:
+			constructDoubleDoubleSSE2(queue, data);
+			return;
+		case Kernel::AVX2:
+			constructDoubleDoubleAVX2(queue, data);
+			return;
+		case Kernel::AVX512:
+			constructDoubleDoubleAVX512(queue, data);
+			return;
+		default:
+			break;
+		}
+
+		unsigned int x, y;
+		while (queue.pop(x, y))
+			data[x + y * width] = getMandelbrotValueDD(x, y);
+		return;
+	}
+
+	switch (kernel) {
+	case Kernel::SSE2:
+		constructSSE2(queue, data);
+		return;
+	case Kernel::AVX2:
+		constructAVX2(queue, data);
+		return;
+	case Kernel::AVX512:
+		constructAVX512(queue, data);
+		return;
+	default:
+		break;
 	}
+
+	unsigned int x, y, interior{ 0 };
+	while (queue.pop(x, y)) {
+		const unsigned int i{ (x + y * width) };
+		double distance{ 0 };
+		const ManVal v{ getMandelbrotValue(x, y, interior, distance) };
+		data[i] = v;
+		data.setDistance(i, distance);
+	}
+	interiorPixels.fetch_add(interior, std::memory_order_relaxed);
 }
 
-void MandelbrotRenderer::colorThread(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight) {
-	for (unsigned int x{ minWidth }; x < maxWidth; x++) {
-		for (unsigned int y{ minHeight }; y < maxHeight; y++) {
+void MandelbrotRenderer::colorThread(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+
+	// The vectorized coloring only knows the smooth coloring
+	const bool distance{ (distanceEstimation || interiorEstimation) && (activePrecision == Precision::Float || activePrecision == Precision::Double) };
+
+	switch (distance ? Kernel::Scalar : kernel) {
+	case Kernel::SSE2:
+		colorSSE2(minWidth, maxWidth, minHeight, maxHeight, data);
+		return;
+	case Kernel::AVX2:
+		colorAVX2(minWidth, maxWidth, minHeight, maxHeight, data);
+		return;
+	case Kernel::AVX512:
+		colorAVX512(minWidth, maxWidth, minHeight, maxHeight, data);
+		return;
+	default:
+		break;
+	}
+
+	// Row by row, data and rgbBuffer are laid out that way
+	for (unsigned int y{ minHeight }; y < maxHeight; y++) {
+		for (unsigned int x{ minWidth }; x < maxWidth; x++) {
 
 			const unsigned int dataIndex{ (x + y * width) };
 			const unsigned int i{ dataIndex * 3 };
 
 			ManVal v{ data[dataIndex] };
-			Color c{ getColor(v.i,v.r,v.c) };
+			Color c{ distance ? getDistanceColor(v, data.distance(dataIndex), data.atom(dataIndex)) : getColor(v.i,v.r,v.c) };
 
 			rgbBuffer[i + 0] = c.r;
 			rgbBuffer[i + 1] = c.g;
@@ -83,58 +943,184 @@ void MandelbrotRenderer::colorThread(const unsigned int minWidth, const unsigned
 	}		
 }
 
+ThreadPool& MandelbrotRenderer::threadPool() {
+	if (!pool)
+		pool = std::make_shared<ThreadPool>();
+	return *pool;
+}
+
 void MandelbrotRenderer::color() {
+	if (data == nullptr)
+		return;
+
 	if (rgbBuffer != nullptr) {
 		delete[] rgbBuffer;
 		rgbBuffer = new char[numPixels * 3];
 	}
 
-	int incrementX = width / tileSize;
-	int incrementY = height / tileSize;
+	const TileGrid grid{ width, height, tileSize };
 
-	threads.clear();
+	threadPool().run(grid.count(), [&](const unsigned int tile) {
+		unsigned int minWidth, maxWidth, minHeight, maxHeight;
+		grid.bounds(tile, minWidth, maxWidth, minHeight, maxHeight);
+		colorThread(minWidth, maxWidth, minHeight, maxHeight, PixelData{ data, 0, distances, atoms });
+	});
+}
 
-	for (int x = 0; x < tileSize; x++) {
-		for (int y = 0; y < tileSize; y++) {
-			threads.push_back(std::thread(&MandelbrotRenderer::colorThread,this, x * incrementX, (x + 1) * (incrementX), y * incrementY, (y + 1) * (incrementX)));
+MandelbrotRenderer::ConstructTile MandelbrotRenderer::prepare() {
+	stats = RenderStats{};
+	interiorPixels = 0;
+	computedPixels = 0;
+	filledPixels = 0;
+	glitches.clear();
 
-		}
-	}
+	activePrecision = precision == Precision::Auto ? selectPrecision() : precision;
 
-	for (unsigned int i{ 0 }; i < threads.size(); ++i)
-	{
-		if (threads[i].joinable()) {
-			threads.at(i).join();
-		}
+	const bool perturbed{ activePrecision == Precision::Perturbation || activePrecision == Precision::SeriesApproximation };
+
+	// Pixel deltas this small would lose their bits as subnormal doubles
+	extendedExponent = extendedZoom < FloatExp{ 1e-290 };
+
+	if (perturbed || activePrecision == Precision::BLA)
+		computeReferenceOrbit(FloatExp{ 0.0 }, FloatExp{ 0.0 });
+	if (activePrecision == Precision::SeriesApproximation) {
+		if (extendedExponent)
+			computeSeries<FloatExp>();
+		else
+			computeSeries<double>();
 	}
+	if (activePrecision == Precision::BLA && !extendedExponent)
+		computeBLATable();
+
+	trackDerivative = distanceEstimation || renderMode == RenderMode::DiscFilling;
+
+	// What the threads run on their tiles
+	if (renderMode == RenderMode::Subdivision)
+		return &MandelbrotRenderer::constructSubdivided;
+	if (renderMode == RenderMode::SolidGuessing)
+		return &MandelbrotRenderer::constructGuessed;
+	if (renderMode == RenderMode::DiscFilling)
+		return &MandelbrotRenderer::constructDiscFilled;
+	return &MandelbrotRenderer::construct;
+}
 
-	
+bool MandelbrotRenderer::estimatesInterior() const {
+	// Only the Float and Double kernels catch cycles, besides the cardioid and bulb test
+	return interiorEstimation && (activePrecision == Precision::Float || activePrecision == Precision::Double);
+}
 
+bool MandelbrotRenderer::storesDistances() const {
+	// Most renders need none, the buffer would only add to every pixel's footprint
+	return trackDerivative || estimatesInterior();
+}
+
+void MandelbrotRenderer::constructImage(const ConstructTile constructTile) {
+	delete[] data;
+	data = new ManVal[numPixels];
+
+	// Zeroed, the kernels only write the estimates they make
+	delete[] distances;
+	distances = storesDistances() ? new double[numPixels]() : nullptr;
+	delete[] atoms;
+	atoms = estimatesInterior() ? new unsigned int[numPixels]() : nullptr;
+
+	// Far more tiles than threads, so a thread done with a cheap tile takes the next one instead of idling
+	// while another one works through the boundary
+	const TileGrid grid{ width, height, tileSize };
+
+	threadPool().run(grid.count(), [&](const unsigned int tile) {
+		unsigned int minWidth, maxWidth, minHeight, maxHeight;
+		grid.bounds(tile, minWidth, maxWidth, minHeight, maxHeight);
+		(this->*constructTile)(minWidth, maxWidth, minHeight, maxHeight, PixelData{ data, 0, distances, atoms });
+	});
+
+	stats.interiorPixels = interiorPixels;
+	stats.computedPixels = computedPixels;
+	stats.filledPixels = filledPixels;
+
+	if (isPerturbedConstruct())
+		correctGlitches();
+
+	if (estimatesInterior()) {
+		const unsigned int numThreads{ threadPool().size() };
+		const unsigned int chunk{ std::max((numPixels + numThreads - 1) / numThreads, 1u) };
+
+		threadPool().run((numPixels + chunk - 1) / chunk, [&](const unsigned int c) {
+			estimateInterior(c * chunk, std::min(c * chunk + chunk, numPixels), PixelData{ data, 0, distances, atoms });
+		});
+	}
 }
 
 void MandelbrotRenderer::generate() {
-	if (data != nullptr) {
-		delete[] data;
-		data = new ManVal[numPixels];
+	constructImage(prepare());
+}
+
+void MandelbrotRenderer::render() {
+	const ConstructTile constructTile{ prepare() };
+
+	// Glitched pixels are only final once all tiles are done
+	if (isPerturbedConstruct()) {
+		constructImage(constructTile);
+		color();
+		return;
 	}
 
-	int incrementX = width / tileSize;
-	int incrementY = height / tileSize;
+	delete[] rgbBuffer;
+	rgbBuffer = new char[numPixels * 3];
 
+	const TileGrid grid{ width, height, tileSize };
 
-	for (int x = 0; x < tileSize; x++) {
-		for (int y = 0; y < tileSize; y++) {
-			threads.push_back(std::thread(&MandelbrotRenderer::construct, this, x * incrementX, (x+1) * (incrementX), y * incrementY, (y + 1) * (incrementX), data));
+	const bool interior{ estimatesInterior() };
+
+	const auto renderTile = [&](const unsigned int tile, const PixelData tileData) {
+		unsigned int minWidth, maxWidth, minHeight, maxHeight;
+		grid.bounds(tile, minWidth, maxWidth, minHeight, maxHeight);
+		(this->*constructTile)(minWidth, maxWidth, minHeight, maxHeight, tileData);
+
+		if (interior) {
+			for (unsigned int y{ minHeight }; y < maxHeight; y++)
+				estimateInterior(minWidth + y * width, maxWidth + y * width, tileData);
 		}
-	}
 
-	for (unsigned int i{ 0 }; i < threads.size(); ++i)
-	{
-		if (threads[i].joinable()) {
-			threads.at(i).join();
+		colorThread(minWidth, maxWidth, minHeight, maxHeight, tileData);
+	};
+
+	delete[] data;
+	data = nullptr;
+	delete[] distances;
+	distances = nullptr;
+	delete[] atoms;
+	atoms = nullptr;
+
+	if (keepData) {
+		data = new ManVal[numPixels];
+		if (storesDistances())
+			distances = new double[numPixels]();
+		if (interior)
+			atoms = new unsigned int[numPixels]();
+		threadPool().run(grid.count(), [&](const unsigned int tile) {
+			renderTile(tile, PixelData{ data, 0, distances, atoms });
+		});
+	}
+	else {
+		// One row of tiles at a time, the buffer starts at the row's first pixel
+		std::vector<ManVal> band((size_t)tileSize * width);
+		std::vector<double> bandDistances(storesDistances() ? band.size() : 0);
+		std::vector<unsigned int> bandAtoms(interior ? band.size() : 0);
+		for (unsigned int row{ 0 }; row < grid.rows(); row++) {
+			std::fill(bandDistances.begin(), bandDistances.end(), 0.0);
+			std::fill(bandAtoms.begin(), bandAtoms.end(), 0);
+			const PixelData rowData{ band.data(), row * tileSize * width, bandDistances.empty() ? nullptr : bandDistances.data(),
+				bandAtoms.empty() ? nullptr : bandAtoms.data() };
+			threadPool().run(grid.columns(), [&](const unsigned int column) {
+				renderTile(row * grid.columns() + column, rowData);
+			});
 		}
 	}
 
+	stats.interiorPixels = interiorPixels;
+	stats.computedPixels = computedPixels;
+	stats.filledPixels = filledPixels;
 }
 
 
@@ -172,12 +1158,18 @@ void MandelbrotRenderer::show() {
 }
 
 ManVal* MandelbrotRenderer::cloneData() {
+	if (data == nullptr)
+		return nullptr;
+
 	ManVal* d = new ManVal[numPixels];
 	std::memcpy(d, data, sizeof(ManVal)*numPixels);
 	return d;
 }
 
 unsigned int* MandelbrotRenderer::cloneIterationData() {
+	if (data == nullptr)
+		return nullptr;
+
 	unsigned int* d = new unsigned int[numPixels];
 	for (unsigned int i{ 0 }; i < numPixels; ++i) {
 		d[i] = data[i].i;
@@ -186,6 +1178,9 @@ unsigned int* MandelbrotRenderer::cloneIterationData() {
 }
 
 double* MandelbrotRenderer::cloneRealData() {
+	if (data == nullptr)
+		return nullptr;
+
 	double* d = new double[numPixels];
 	for (unsigned int i{ 0 }; i < numPixels; ++i) {
 		d[i] = data[i].r;
@@ -194,6 +1189,9 @@ double* MandelbrotRenderer::cloneRealData() {
 }
 
 double* MandelbrotRenderer::cloneImaginaryData() {
+	if (data == nullptr)
+		return nullptr;
+
 	double* d = new double[numPixels];
 	for (unsigned int i{ 0 }; i < numPixels; ++i) {
 		d[i] = data[i].c;
@@ -201,6 +1199,24 @@ double* MandelbrotRenderer::cloneImaginaryData() {
 	return d;
 }
 
+double* MandelbrotRenderer::cloneDistanceData() {
+	if (distances == nullptr)
+		return nullptr;
+
+	double* d = new double[numPixels];
+	std::memcpy(d, distances, sizeof(double)*numPixels);
+	return d;
+}
+
+unsigned int* MandelbrotRenderer::cloneAtomData() {
+	if (atoms == nullptr)
+		return nullptr;
+
+	unsigned int* d = new unsigned int[numPixels];
+	std::memcpy(d, atoms, sizeof(unsigned int)*numPixels);
+	return d;
+}
+
 char* MandelbrotRenderer::cloneRGB() {
 	char* d = new char[numPixels*3];
 	std::memcpy(d, rgbBuffer, sizeof(char)*numPixels*3);
@@ -1,12 +1,20 @@
 #pragma once
 
 #include "GL_Utils.h"
+#include "CPU_Utils.h"
+#include "DoubleDouble.h"
+#include "BigFloat.h"
+#include "FloatExp.h"
+#include "ThreadPool.h"
 
 #include <cstdlib>
 #include <stdlib.h>
 #include <stdio.h>
 #include <thread>
+#include <atomic>
+#include <mutex>
 #include <vector>
+#include <algorithm>
 #include <iomanip>      // std::setprecisio
 #include <ctime>
 
@@ -18,14 +26,214 @@ struct Color {
 struct ManVal {
 	double r, c;
 	unsigned int i;
+	unsigned int p{ 0 };	// Period of the cycle an interior orbit was caught in, 0 if none was detected
 };
 
+/* The ManVals of the pixels from first on, indexed with x + y * width like the whole image. render() keeps
+   only one row of tiles in such a buffer */
+struct PixelData {
+	ManVal* values;
+	unsigned int first;
+
+	// Distances to the boundary of the set, nullptr when nothing estimates them
+	double* distances;
+
+	// Atom domain periods of periodic pixels, nullptr without interior estimation
+	unsigned int* atoms;
+
+	ManVal& operator[](const unsigned int pixel) const {
+		return values[pixel - first];
+	}
+
+	double distance(const unsigned int pixel) const {
+		return distances != nullptr ? distances[pixel - first] : 0;
+	}
+
+	void setDistance(const unsigned int pixel, const double distance) const {
+		if (distances != nullptr)
+			distances[pixel - first] = distance;
+	}
+
+	unsigned int atom(const unsigned int pixel) const {
+		return atoms != nullptr ? atoms[pixel - first] : 0;
+	}
+
+	void setAtom(const unsigned int pixel, const unsigned int atom) const {
+		if (atoms != nullptr)
+			atoms[pixel - first] = atom;
+	}
+
+	/* A filled pixel takes over everything stored for the one it copies. Atom domains are estimated after
+	   construction, for the filled pixels as well */
+	void copy(const unsigned int pixel, const unsigned int source) const {
+		values[pixel - first] = values[source - first];
+		if (distances != nullptr)
+			distances[pixel - first] = distances[source - first];
+	}
+};
+
+/* Pixels still waiting to be computed, a rectangle handed out row by row or a list of pixel indices */
+struct PixelQueue {
+	unsigned int minWidth, maxWidth, maxHeight;
+	unsigned int x, y;
+
+	const unsigned int* list{ nullptr };
+	unsigned int listSize{ 0 };
+	unsigned int width{ 0 };
+
+	static PixelQueue rectangle(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight) {
+		return PixelQueue{ minWidth, maxWidth, maxHeight, minWidth, minHeight };
+	}
+
+	/* pixels are indices x + y * width */
+	static PixelQueue pixels(const std::vector<unsigned int>& pixels, const unsigned int width) {
+		return PixelQueue{ 0, 0, 0, 0, 0, pixels.data(), (unsigned int)pixels.size(), width };
+	}
+
+	bool pop(unsigned int& px, unsigned int& py) {
+		if (list != nullptr) {
+			if (x >= listSize)
+				return false;
+
+			px = list[x] % width;
+			py = list[x] / width;
+			x++;
+			return true;
+		}
+
+		if (x >= maxWidth || y >= maxHeight)
+			return false;
+
+		px = x;
+		py = y;
+
+		if (++x == maxWidth) {
+			x = minWidth;
+			y++;
+		}
+		return true;
+	}
+};
+
+/* Square tiles of at most size pixels covering a width x height image, row by row. The last column and row
+   of tiles are cut short by whatever remains, so any size is covered */
+struct TileGrid {
+	unsigned int width, height, size;
+
+	unsigned int columns() const {
+		return (width + size - 1) / size;
+	}
+
+	unsigned int rows() const {
+		return (height + size - 1) / size;
+	}
+
+	unsigned int count() const {
+		return columns() * rows();
+	}
+
+	void bounds(const unsigned int tile, unsigned int& minWidth, unsigned int& maxWidth, unsigned int& minHeight, unsigned int& maxHeight) const {
+		minWidth = tile % columns() * size;
+		minHeight = tile / columns() * size;
+		maxWidth = std::min(minWidth + size, width);
+		maxHeight = std::min(minHeight + size, height);
+	}
+};
+
+/* Pixel whose delta outgrew the reference orbit */
+struct Glitch {
+	unsigned int pixel;
+	double ratio;	// |z|^2 / |Z|^2 when detected, the smallest lies deepest inside the glitch
+};
+
+/* delta -> A delta + B delta_0 over a run of reference iterations, valid while |delta| < radius */
+struct BLAStep {
+	double aRe, aIm;
+	double bRe, bIm;
+	double radius;
+};
+
+/* Counters of the last generate() */
+struct RenderStats {
+	unsigned int references{ 0 };		// Reference orbits computed by the perturbation modes
+	unsigned int glitchedPixels{ 0 };	// Pixels still glitched after the last reference
+	unsigned int skippedIterations{ 0 };	// Iterations Precision::SeriesApproximation started every pixel at
+	unsigned int interiorPixels{ 0 };	// Pixels inside the main cardioid or the period 2 bulb, never iterated
+	unsigned int computedPixels{ 0 };	// Pixels the filling render modes iterated
+	unsigned int filledPixels{ 0 };		// Pixels the filling render modes filled in without iterating
+};
+
+/* Kernels construct() and colorThread() can dispatch to */
+enum class Kernel {
+	Auto,	// Widest instruction set the CPU supports
+	Scalar,	// getMandelbrotValue, one pixel at a time
+	SSE2,	// 2 pixels per __m128d
+	AVX2,	// 4 pixels per __m256d
+	AVX512	// 8 pixels per __m512d
+};
+
+/* Arithmetic used for the escape time iteration */
+enum class Precision {
+	Auto,			// Cheapest of the others that still resolves the pixels, picked by generate()
+	Float,			// 24 bits, enough for thumbnails and overviews
+	Double,			// Pixelates below a zoom of about 1e-13
+	DoubleDouble,	// About 106 bits, good down to a zoom of about 1e-28
+	Perturbation,	// Double deltas against one BigFloat reference orbit at the view center
+	SeriesApproximation,	// Perturbation, starting every pixel from a series for the iterations they share
+	BLA				// One reference with rebasing, jumping over runs of iterations with bilinear approximations
+};
+/*
+	How generate() covers a tile. Subdivision, SolidGuessing and DiscFilling give a filled pixel
+	the ManVal of the pixel it copies, final z, period and distance estimate included. Only the iteration counts
+	match PerPixel: smooth, distance and interior coloring turn flat over filled regions, and estimateInterior()
+	may refine a filled pixel with its neighbour's period. They are meant for iteration count coloring,
+	exports that color by anything else need PerPixel.
+*/
+enum class RenderMode {
+	PerPixel,		// Every pixel iterated
+	Subdivision,	// Mariani-Silver, rectangles whose border shares one iteration count are filled
+	SolidGuessing,	// A coarse grid refined in passes, blocks whose corners agree are guessed instead of refined
+	DiscFilling		// Pixels inside the exterior disc distance estimation guarantees around a computed one are filled
+};
+
+/* Closed form membership of the main cardioid and the period 2 bulb, whose points never escape.
+   Returns the period of the cycle their orbits settle in, 0 outside of both */
+static inline unsigned int interiorPeriod(const double a, const double b) {
+	const double shifted{ a - 0.25 };
+	const double q{ shifted * shifted + b * b };
+	if (q * (q + shifted) <= 0.25 * b * b)
+		return 1;
+
+	return (a + 1) * (a + 1) + b * b <= 0.0625 ? 2 : 0;
+}
+
+/* Exterior distance estimate 2 |z| ln|z| / |dz/dc| of an escaped orbit, continued past the escape radius first
+   since the estimate only holds for large |z|. By Koebe's 1/4 theorem the disc of a quarter of it around c
+   lies outside the set. 0 when the derivative overflowed */
+static inline double distanceEstimate(double a, double b, double da, double db, const double ca, const double cb) {
+	for (unsigned int n{ 0 }; n < 64 && a * a + b * b < 1e10; n++) {
+		const double newDa{ 2 * (a * da - b * db) + 1 };
+		db = 2 * (a * db + b * da);
+		da = newDa;
+
+		const double newA{ a * a - b * b + ca };
+		b = 2 * a * b + cb;
+		a = newA;
+	}
+
+	const double size{ a * a + b * b };
+	const double estimate{ std::sqrt(size) * std::log(size) / std::sqrt(da * da + db * db) };
+	return estimate > 0 && estimate < INFINITY ? estimate : 0;
+}
 
 class MandelbrotRenderer {
 private:
-	std::vector<std::thread> threads;
+	/* Runs the tiles of generate() and color(), shared with other renderers through setThreadPool().
+	   Empty until threadPool() first needs one, so a renderer given a pool never starts threads of its own */
+	std::shared_ptr<ThreadPool> pool;
 
-	const int tileSize = 2;
+	/* Edge length of the square tiles generate() and color() hand to the pool */
+	unsigned int tileSize{ 64 };
 
 	unsigned int width{ 100 };
 	unsigned int height{ 100 };
@@ -34,23 +242,180 @@ private:
 	double dy{ 0 };
 	unsigned int maxIterations{ 100 };
 	double zoom{ 2 };
+
+	/* zoom with an exponent a double cannot hold, below about 1e-290 the perturbation modes switch to FloatExp deltas */
+	FloatExp extendedZoom{ 2.0 };
+	bool extendedExponent{ false };
 	GLFWwindow* window{ nullptr };
 	ManVal* data{ nullptr };
+	double* distances{ nullptr };
+	unsigned int* atoms{ nullptr };
 	char* rgbBuffer{ nullptr };
 	unsigned int numPixels{ width*height };
 
+	/* Requested precision and the one generate() resolved Auto to */
+	Precision precision{ Precision::Auto };
+	Precision activePrecision{ Precision::Double };
+
+	/* Bits on top of the pixel spacing Auto demands, for the rounding error the iteration accumulates */
+	const int guardBits{ 4 };
+
+	/* dx / dy with the digits a double cannot hold, used by Precision::DoubleDouble */
+	DoubleDouble centerX{ 0, 0 };
+	DoubleDouble centerY{ 0, 0 };
+
+	/* Exact center as passed to setCenter(), empty if only the doubles are known */
+	std::string centerRe;
+	std::string centerIm;
+
+	/* Orbits escape once |z|^2 exceeds the square of the escape radius. The smooth coloring's fraction is divided
+	   by log2 of the radius, which keeps it continuous for any radius and the plain formula for 2 */
+	double bailoutSquared{ 4 };
+	double smoothingScale{ 1 };
+
+	/* BigFloat only holds values below 2^32, so reference orbits stop at |Z| = 2^15 for larger radii */
+	const double referenceBailoutSquared{ 1073741824.0 };
+
+	/* Orbit for the perturbation modes, ends after it escapes. The first one is the view center,
+	   the offset is the reference's position relative to it */
+	std::vector<double> referenceA;
+	std::vector<double> referenceB;
+	FloatExp referenceOffsetA;
+	FloatExp referenceOffsetB;
+
+	/* Pauldelbrot's criterion |z|^2 < tolerance * |Z|^2, glitched pixels get a new reference */
+	bool glitchCorrection{ true };
+	const double glitchTolerance{ 1e-6 };
+	const unsigned int maxReferences{ 64 };
+	std::vector<Glitch> glitches;
+	std::mutex glitchMutex;
+
+	/* delta_n ~ A delta_0 + B delta_0^2 + C delta_0^3 after seriesSkip iterations of the view center's orbit,
+	   the coefficients as real and imaginary parts */
+	unsigned int seriesSkip{ 0 };
+	FloatExp seriesRe[3];
+	FloatExp seriesIm[3];
+	const double seriesTolerance{ 1e-12 };
+
+	/* Bilinear approximations of the reference for Precision::BLA, level k holds the steps over 2^k iterations
+	   starting at the multiples of 2^k */
+	std::vector<std::vector<BLAStep>> blaTable;
+
+	RenderStats stats;
+
+	/* Brent's cycle detection in the Float and Double kernels, pixels whose orbit comes back to the point saved
+	   at the last power of 2 iterations within the squared distance below are interior */
+	bool periodicityChecking{ true };
+	const double periodTolerance{ 1e-20 };
+	const float periodToleranceFloat{ 1e-12f };
+
+	/* Counted by the construct tasks, copied into stats once they finished */
+	std::atomic<unsigned int> interiorPixels{ 0 };
+	std::atomic<unsigned int> computedPixels{ 0 };
+	std::atomic<unsigned int> filledPixels{ 0 };
+
+	/* Distance estimation as requested and whether generate() needs it, RenderMode::DiscFilling does */
+	bool distanceEstimation{ false };
+	bool trackDerivative{ false };
+
+	/* Pass over the pixels the periodicity check or interiorPeriod() found periodic after generate() */
+	bool interiorEstimation{ false };
+
+	/* Whether render() leaves the ManVal of every pixel behind, without it only one row of tiles is held at a time */
+	bool keepData{ true };
+
+	RenderMode renderMode{ RenderMode::PerPixel };
+
+	/* Rectangles of RenderMode::Subdivision at most this wide and high are iterated instead of split further */
+	const unsigned int subdivisionMinSize{ 16 };
+
+	/* Spacing of the first RenderMode::SolidGuessing pass, halved by each of the following ones. The strictness
+	   is how many rings of neighbouring blocks also have to agree before a block is guessed */
+	const unsigned int guessStep{ 8 };
+	unsigned int guessStrictness{ 1 };
+
+	/* Probed once, the kernel is picked from it */
+	const CPUFeatures cpu{ detectCPUFeatures() };
+	Kernel kernel{ Kernel::Scalar };
+
 	/* Gradient from https://www.strangeplanet.fr/work/gradient-generator/index.php */
 	const std::string hex[512]{
 		"000764", "000764", "000865", "000966", "010A67", "010A68", "010B68", "010C69", "020D6A", "020D6B", "020E6C", "020F6C", "03106D", "03116E", "03116F", "031270", "041370", "041471", "041472", "041573", "051674", "051774", "051875", "051876", "061977", "061A78", "061B78", "061B79", "071C7A", "071D7B", "071E7C", "071E7C", "081F7D", "08207E", "08217F", "082280", "092280", "092381", "092482", "092583", "0A2584", "0A2684", "0A2785", "0A2886", "0B2987", "0B2988", "0B2A89", "0B2B89", "0C2C8A", "0C2C8B", "0C2D8C", "0C2E8D", "0D2F8D", "0D2F8E", "0D308F", "0D3190", "0E3291", "0E3391", "0E3392", "0E3493", "0F3594", "0F3695", "0F3695", "0F3796", "103897", "103998", "103A99", "103A99", "113B9A", "113C9B", "113D9C", "113D9D", "123E9D", "123F9E", "12409F", "1241A0", "1341A1", "1342A1", "1343A2", "1344A3", "1444A4", "1445A5", "1446A5", "1447A6", "1547A7", "1548A8", "1549A9", "154AAA", "164BAA", "164BAB", "164CAC", "164DAD", "174EAE", "174EAE", "174FAF", "1750B0", "1851B1", "1852B2", "1852B2", "1853B3", "1954B4", "1955B5", "1955B6", "1956B6", "1A57B7", "1A58B8", "1A58B9", "1A59BA", "1B5ABA", "1B5BBB", "1B5CBC", "1B5CBD", "1C5DBE", "1C5EBE", "1C5FBF", "1C5FC0", "1D60C1", "1D61C2", "1D62C2", "1D63C3", "1E63C4", "1E64C5", "1E65C6", "1E66C6", "1F66C7", "1F67C8", "1F68C9", "1F69CA", "206ACB", "216BCB", "236CCB", "246DCC", "266ECC", "286FCD", "2970CD", "2B72CD", "2C73CE", "2E74CE", "3075CF", "3176CF", "3377CF", "3479D0", "367AD0", "387BD1", "397CD1", "3B7DD1", "3C7ED2", "3E80D2", "4081D3", "4182D3", "4383D3", "4584D4", "4685D4", "4887D5", "4988D5", "4B89D5", "4D8AD6", "4E8BD6", "508CD7", "518ED7", "538FD8", "5590D8", "5691D8", "5892D9", "5993D9", "5B95DA", "5D96DA", "5E97DA", "6098DB", "6199DB", "639ADC", "659CDC", "669DDC", "689EDD", "6A9FDD", "6BA0DE", "6DA1DE", "6EA3DE", "70A4DF", "72A5DF", "73A6E0", "75A7E0", "76A8E0", "78AAE1", "7AABE1", "7BACE2", "7DADE2", "7EAEE2", "80AFE3", "82B1E3", "83B2E4", "85B3E4", "87B4E5", "88B5E5", "8AB6E5", "8BB7E6", "8DB9E6", "8FBAE7", "90BBE7", "92BCE7", "93BDE8", "95BEE8", "97C0E9", "98C1E9", "9AC2E9", "9BC3EA", "9DC4EA", "9FC5EB", "A0C7EB", "A2C8EB", "A3C9EC", "A5CAEC", "A7CBED", "A8CCED", "AACEED", "ACCFEE", "ADD0EE", "AFD1EF", "B0D2EF", "B2D3EF", "B4D5F0", "B5D6F0", "B7D7F1", "B8D8F1", "BAD9F2", "BCDAF2", "BDDCF2", "BFDDF3", "C0DEF3", "C2DFF4", "C4E0F4", "C5E1F4", "C7E3F5", "C8E4F5", "CAE5F6", "CCE6F6", "CDE7F6", "CFE8F7", "D1EAF7", "D2EBF8", "D4ECF8", "D5EDF8", "D7EEF9", "D9EFF9", "DAF1FA", "DCF2FA", "DDF3FA", "DFF4FB", "E1F5FB", "E2F6FC", "E4F8FC", "E5F9FC", "E7FAFD", "E9FBFD", "EAFCFE", "ECFDFE", "EEFFFF", "EEFEFD", "EEFDFB", "EEFDF9", "EEFCF7", "EEFBF5", "EEFBF3", "EEFAF1", "EFF9EF", "EFF9ED", "EFF8EB", "EFF7E9", "EFF7E7", "EFF6E5", "EFF5E3", "EFF5E1", "F0F4DF", "F0F3DD", "F0F3DB", "F0F2D9", "F0F1D7", "F0F1D5", "F0F0D3", "F1EFD1", "F1EFCF", "F1EECD", "F1EDCB", "F1EDC9", "F1ECC7", "F1EBC5", "F1EBC3", "F2EAC1", "F2E9BF", "F2E9BD", "F2E8BB", "F2E7B9", "F2E7B7", "F2E6B5", "F3E5B3", "F3E5B1", "F3E4AF", "F3E3AD", "F3E3AB", "F3E2A9", "F3E1A7", "F3E1A5", "F4E0A3", "F4DFA1", "F4DF9F", "F4DE9D", "F4DD9B", "F4DD99", "F4DC97", "F5DB95", "F5DB93", "F5DA91", "F5D98F", "F5D98D", "F5D88B", "F5D789", "F5D787", "F6D685", "F6D583", "F6D581", "F6D47F", "F6D37D", "F6D37B", "F6D279", "F7D177", "F7D175", "F7D073", "F7CF71", "F7CF6F", "F7CE6D", "F7CD6B", "F7CD69", "F8CC67", "F8CB65", "F8CB63", "F8CA61", "F8C95F", "F8C95D", "F8C85B", "F9C759", "F9C757", "F9C655", "F9C553", "F9C551", "F9C44F", "F9C34D", "F9C34B", "FAC249", "FAC147", "FAC145", "FAC043", "FABF41", "FABF3F", "FABE3D", "FBBD3B", "FBBD39", "FBBC37", "FBBB35", "FBBB33", "FBBA31", "FBB92F", "FBB92D", "FCB82B", "FCB729", "FCB727", "FCB625", "FCB523", "FCB521", "FCB41F", "FDB31D", "FDB31B", "FDB219", "FDB117", "FDB115", "FDB013", "FDAF11", "FDAF0F", "FEAE0D", "FEAD0B", "FEAD09", "FEAC07", "FEAB05", "FEAB03", "FEAA01", "FFAA00", "FCA800", "FAA700", "F8A600", "F6A400", "F4A300", "F2A200", "F0A000", "EE9F00", "EC9E00", "EA9C00", "E89B00", "E69A00", "E49800", "E29700", "E09600", "DE9400", "DC9300", "DA9200", "D89000", "D68F00", "D48E00", "D28C00", "D08B00", "CE8A00", "CC8800", "CA8700", "C88600", "C68400", "C48300", "C28200", "C08000", "BE7F00", "BC7E00", "BA7D00", "B87B00", "B67A00", "B47900", "B27700", "B07600", "AE7500", "AC7300", "AA7200", "A87100", "A66F00", "A46E00", "A26D00", "A06B00", "9E6A00", "9C6900", "9A6700", "986600", "966500", "946300", "926200", "906100", "8E5F00", "8C5E00", "8A5D00", "885B00", "865A00", "845900", "825700", "805600", "7E5500", "7C5400", "7A5200", "785100", "765000", "744E00", "724D00", "704C00", "6E4A00", "6C4900", "6A4800", "684600", "664500", "644400", "624200", "604100", "5E4000", "5C3E00", "5A3D00", "583C00", "563A00", "543900", "523800", "503600", "4E3500", "4C3400", "4A3200", "483100", "463000", "442E00", "422D00", "402C00", "3E2B00", "3C2900", "3A2800", "382700", "362500", "342400", "322300", "302100", "2E2000", "2C1F00", "2A1D00", "281C00", "261B00", "241900", "221800", "201700", "1E1500", "1C1400", "1A1300", "181100", "161000", "140F00", "120D00", "100C00", "0E0B00", "0C0900", "0A0800", "080700", "060500", "040400", "020300", "000200"
 	};
 	
+	/* hex parsed once in the constructor */
+	Color palette[512];
+
 	/* Coloring method from https://stackoverflow.com/a/25816111 */
 	const double ONE_OVER_LOG2{ 1.442695040889 };
 
 	Color getColor(const int i, const double r, const double c);
-	ManVal getMandelbrotValue(const int x, const int y);
-	void construct(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, ManVal* data);
-	void MandelbrotRenderer::colorThread(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight);
+	Color getDistanceColor(const ManVal& value, const double distance, const unsigned int atom);
+	/* Both add the pixels the cardioid and bulb test fills to interior, the caller hands its count to interiorPixels once */
+	ManVal getMandelbrotValue(const int x, const int y, unsigned int& interior, double& distance);
+	ManVal getMandelbrotValueFloat(const int x, const int y, unsigned int& interior, double& distance);
+	ManVal getMandelbrotValueDD(const int x, const int y);
+	template <typename T>
+	T pixelOffset(const int value, const unsigned int size) const;
+	template <typename T>
+	ManVal getPerturbedValue(const int x, const int y, bool& glitched, double& ratio);
+	void computeReferenceOrbit(const FloatExp offsetA, const FloatExp offsetB);
+	template <typename T>
+	void computeSeries();
+	ManVal getBLAValue(const int x, const int y);
+	void computeBLATable();
+	void constructPerturbed(PixelQueue queue, const PixelData data, std::vector<Glitch>& tileGlitches);
+	bool isPerturbedConstruct() const;
+	void estimateInterior(const unsigned int begin, const unsigned int end, const PixelData data);
+	void perturbGlitches(const std::vector<Glitch>* pending, const size_t begin, const size_t end);
+	void correctGlitches();
+	Precision selectPrecision() const;
+	ThreadPool& threadPool();
+
+	/* Steps of generate() shared with render(), prepare() resolves the precision and returns what the tiles run */
+	typedef void (MandelbrotRenderer::*ConstructTile)(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	ConstructTile prepare();
+	void constructImage(const ConstructTile constructTile);
+	bool estimatesInterior() const;
+	bool storesDistances() const;
+	void construct(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	void constructQueue(PixelQueue queue, const PixelData data);
+
+	/* The filling render modes on one thread's tile, defined in MandelRenderer_Modes.cpp */
+	struct FillState;
+	void constructSubdivided(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	void constructGuessed(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	void computePixels(FillState& state, const PixelQueue queue, const unsigned int count);
+	void finishFill(FillState& state);
+	void computeRect(FillState& state, const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight);
+	void subdivide(FillState& state, const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight);
+	void constructDiscFilled(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+
+	/* Vectorized construct(), defined in SIMD_Kernels.h and instantiated per instruction set */
+	template <class V, bool Derivative = false>
+	void constructSIMD(PixelQueue queue, const PixelData data);
+	void constructSSE2(PixelQueue queue, const PixelData data);
+	void constructAVX2(PixelQueue queue, const PixelData data);
+	void constructAVX512(PixelQueue queue, const PixelData data);
+	void constructFloatSSE2(PixelQueue queue, const PixelData data);
+	void constructFloatAVX2(PixelQueue queue, const PixelData data);
+	void constructFloatAVX512(PixelQueue queue, const PixelData data);
+
+	/* Vectorized getMandelbrotValueDD() */
+	template <class V>
+	void constructSIMDDoubleDouble(PixelQueue queue, const PixelData data);
+	void constructDoubleDoubleSSE2(PixelQueue queue, const PixelData data);
+	void constructDoubleDoubleAVX2(PixelQueue queue, const PixelData data);
+	void constructDoubleDoubleAVX512(PixelQueue queue, const PixelData data);
+
+	void MandelbrotRenderer::colorThread(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+
+	/* Vectorized colorThread(), same structure as constructSIMD */
+	template <class V>
+	void colorSIMD(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	void colorSSE2(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	void colorAVX2(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
+	void colorAVX512(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data);
 
 public:
 
@@ -59,7 +424,15 @@ public:
 	{		
 		numPixels = width*height;
 		data = new ManVal[numPixels];
+		centerX = DoubleDouble{ dx, 0 };
+		centerY = DoubleDouble{ dy, 0 };
+		extendedZoom = FloatExp{ zoom };
 		rgbBuffer = new char[numPixels *3];
+
+		for (unsigned int i{ 0 }; i < 512; ++i)
+			sscanf_s(hex[i].c_str(), "%02x%02x%02x", &palette[i].r, &palette[i].g, &palette[i].b);
+
+		setKernel(Kernel::Auto);
 	}
 
 	/* Prohibit copy / move construct / assign */
@@ -70,14 +443,113 @@ public:
 
 	~MandelbrotRenderer() {
 		delete[] data;
+		delete[] distances;
+		delete[] atoms;
 		delete[] rgbBuffer;
 	}
 
 	void exportPPM() const;
 	void color();
 	void generate();
+
+	/* generate() and color() in one pass, every tile is colored right after it was iterated while its values are
+	   still in cache. Perturbation renders correct glitches across tiles first and take two passes anyway */
+	void render();
+
 	void show();
 
+	/* Overrides the kernel used by generate() and color(), unsupported ones fall back to Auto */
+	void setKernel(const Kernel kernel);
+
+	Kernel getKernel() const {
+		return kernel;
+	}
+
+	const char* getKernelName() const;
+
+	/* Precision used by the next generate(), anything but Auto forces it */
+	void setPrecision(const Precision precision) {
+		this->precision = precision;
+	}
+
+	/* Precision the last generate() rendered with */
+	Precision getPrecision() const {
+		return activePrecision;
+	}
+
+	const char* getPrecisionName() const;
+
+	/* Sets dx / dy from decimal strings, keeping the digits beyond double precision for deep zooms */
+	void setCenter(const std::string& re, const std::string& im);
+
+	/* Sets the zoom from a decimal string like "1e-500", the perturbation modes render zooms beyond 1e-308 */
+	void setZoom(const std::string& zoom);
+
+	/* Render mode used by the next generate(), see RenderMode for what the filling modes leave inexact */
+	void setRenderMode(const RenderMode renderMode) {
+		this->renderMode = renderMode;
+	}
+
+	RenderMode getRenderMode() const {
+		return renderMode;
+	}
+
+	/* 0 guesses from a block's own corners, every step up checks one more ring of blocks around it.
+	   Higher is slower, but less likely to lose filaments thinner than the first pass's spacing */
+	void setGuessStrictness(const unsigned int strictness) {
+		guessStrictness = strictness;
+	}
+
+	/* Tracks dz/dc to estimate every escaped pixel's distance to the set, color() then darkens the pixels close
+	   to it. Only the Float and Double precisions estimate distances */
+	void setDistanceEstimation(const bool enabled) {
+		distanceEstimation = enabled;
+	}
+
+	/* Estimates the interior distance and atom domain of every periodic pixel, color() then shades the interior
+	   by them. Only the Float and Double precisions catch cycles */
+	void setInteriorEstimation(const bool enabled) {
+		interiorEstimation = enabled;
+	}
+
+	/* Escape radius, at least 2. Escaping pixels take about 3 more iterations at 256 and 5 more at 1e10,
+	   in exchange the smooth coloring gets continuous */
+	void setBailout(const double radius) {
+		const double clamped{ std::max(radius, 2.0) };
+		bailoutSquared = clamped * clamped;
+		smoothingScale = 1 / std::log2(clamped);
+	}
+
+	/* Ends interior orbits once they cycle, costs a little on views without interior pixels */
+	void setPeriodicityChecking(const bool enabled) {
+		periodicityChecking = enabled;
+	}
+
+	/* Smaller tiles balance better across many cores, larger ones cost the filling render modes fewer borders */
+	void setTileSize(const unsigned int size) {
+		tileSize = std::max(size, 1u);
+	}
+
+	/* Renders on the given pool from now on, renderers sharing one do not oversubscribe the CPU */
+	void setThreadPool(const std::shared_ptr<ThreadPool>& pool) {
+		this->pool = pool;
+	}
+
+	/* false lets render() skip the ManVal buffer, when only the RGB image is wanted. color() and the clone
+	   functions other than cloneRGB() then need a generate() first */
+	void setKeepData(const bool enabled) {
+		keepData = enabled;
+	}
+
+	/* Re-renders glitched pixels of the perturbation modes against additional references */
+	void setGlitchCorrection(const bool enabled) {
+		glitchCorrection = enabled;
+	}
+
+	const RenderStats& getStats() const {
+		return stats;
+	}
+
 	const unsigned int getNumPixels() inline const {
 		return numPixels;
 	}
@@ -86,6 +558,12 @@ public:
 	unsigned int* cloneIterationData();
 	double* cloneRealData();
 	double* cloneImaginaryData();
+
+	/* Distance estimates of the last generate(), nullptr unless distance or interior estimation was on */
+	double* cloneDistanceData();
+
+	/* Atom domain periods of the last generate(), nullptr unless interior estimation was on */
+	unsigned int* cloneAtomData();
 	char* cloneRGB();
 
 
@@ -0,0 +1,80 @@
+#include "SIMD_Kernels.h"
+
+#include <immintrin.h>
+
+/* 4 doubles per __m256d */
+struct AVX2Double {
+	typedef double Scalar;
+	typedef __m256d Vec;
+	typedef __m256d Mask;
+	static const unsigned int lanes{ 4 };
+
+	static Vec set1(const double v) { return _mm256_set1_pd(v); }
+	static Vec load(const double* p) { return _mm256_load_pd(p); }
+	static void store(double* p, const Vec v) { _mm256_store_pd(p, v); }
+	static void storeIndex(int* p, const Vec v) { _mm_store_si128((__m128i*)p, _mm256_cvttpd_epi32(v)); }
+	static Vec add(const Vec a, const Vec b) { return _mm256_add_pd(a, b); }
+	static Vec sub(const Vec a, const Vec b) { return _mm256_sub_pd(a, b); }
+	static Vec mul(const Vec a, const Vec b) { return _mm256_mul_pd(a, b); }
+	static Vec div(const Vec a, const Vec b) { return _mm256_div_pd(a, b); }
+	static Vec sqrt(const Vec a) { return _mm256_sqrt_pd(a); }
+	static Vec abs(const Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+	// Biased exponent bits ORed into 2^52 turn into an exact double
+	static Vec exponent(const Vec a) {
+		const __m256i biased{ _mm256_srli_epi64(_mm256_castpd_si256(a), 52) };
+		const __m256d magic{ _mm256_castsi256_pd(_mm256_or_si256(biased, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)))) };
+		return _mm256_sub_pd(magic, _mm256_set1_pd(4503599627370496.0 + 1023));
+	}
+	static Vec mantissa(const Vec a) { return _mm256_or_pd(_mm256_and_pd(a, _mm256_castsi256_pd(_mm256_set1_epi64x(0x000FFFFFFFFFFFFF))), _mm256_set1_pd(1)); }
+	static Vec productError(const Vec a, const Vec b, const Vec p) { return _mm256_fmsub_pd(a, b, p); }
+	static Mask greater(const Vec a, const Vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+	static Vec select(const Mask m, const Vec a, const Vec b) { return _mm256_blendv_pd(b, a, m); }
+	static Mask all() { return _mm256_castsi256_pd(_mm256_set1_epi64x(-1)); }
+	static Mask maskAnd(const Mask a, const Mask b) { return _mm256_and_pd(a, b); }
+	static Mask maskAndNot(const Mask a, const Mask b) { return _mm256_andnot_pd(b, a); }
+	static int bits(const Mask m) { return _mm256_movemask_pd(m); }
+};
+
+/* 8 floats per __m256 */
+struct AVX2Float {
+	typedef float Scalar;
+	typedef __m256 Vec;
+	typedef __m256 Mask;
+	static const unsigned int lanes{ 8 };
+
+	static Vec set1(const float v) { return _mm256_set1_ps(v); }
+	static Vec load(const float* p) { return _mm256_load_ps(p); }
+	static void store(float* p, const Vec v) { _mm256_store_ps(p, v); }
+	static Vec add(const Vec a, const Vec b) { return _mm256_add_ps(a, b); }
+	static Vec sub(const Vec a, const Vec b) { return _mm256_sub_ps(a, b); }
+	static Vec mul(const Vec a, const Vec b) { return _mm256_mul_ps(a, b); }
+	static Vec abs(const Vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static Mask greater(const Vec a, const Vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Vec select(const Mask m, const Vec a, const Vec b) { return _mm256_blendv_ps(b, a, m); }
+	static Mask maskAnd(const Mask a, const Mask b) { return _mm256_and_ps(a, b); }
+	static Mask maskAndNot(const Mask a, const Mask b) { return _mm256_andnot_ps(b, a); }
+	static int bits(const Mask m) { return _mm256_movemask_ps(m); }
+};
+
+void MandelbrotRenderer::constructAVX2(PixelQueue queue, const PixelData data) {
+	if (trackDerivative)
+		constructSIMD<AVX2Double, true>(queue, data);
+	else
+		constructSIMD<AVX2Double>(queue, data);
+}
+
+void MandelbrotRenderer::constructDoubleDoubleAVX2(PixelQueue queue, const PixelData data) {
+	constructSIMDDoubleDouble<AVX2Double>(queue, data);
+}
+
+void MandelbrotRenderer::colorAVX2(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	colorSIMD<AVX2Double>(minWidth, maxWidth, minHeight, maxHeight, data);
+}
+
+void MandelbrotRenderer::constructFloatAVX2(PixelQueue queue, const PixelData data) {
+	if (trackDerivative)
+		constructSIMD<AVX2Float, true>(queue, data);
+	else
+		constructSIMD<AVX2Float>(queue, data);
+}
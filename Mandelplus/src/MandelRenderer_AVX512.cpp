@@ -0,0 +1,74 @@
+#include "SIMD_Kernels.h"
+
+#include <immintrin.h>
+
+/* 8 doubles per __m512d, masks live in k registers */
+struct AVX512Double {
+	typedef double Scalar;
+	typedef __m512d Vec;
+	typedef __mmask8 Mask;
+	static const unsigned int lanes{ 8 };
+
+	static Vec set1(const double v) { return _mm512_set1_pd(v); }
+	static Vec load(const double* p) { return _mm512_load_pd(p); }
+	static void store(double* p, const Vec v) { _mm512_store_pd(p, v); }
+	static void storeIndex(int* p, const Vec v) { _mm256_store_si256((__m256i*)p, _mm512_cvttpd_epi32(v)); }
+	static Vec add(const Vec a, const Vec b) { return _mm512_add_pd(a, b); }
+	static Vec sub(const Vec a, const Vec b) { return _mm512_sub_pd(a, b); }
+	static Vec mul(const Vec a, const Vec b) { return _mm512_mul_pd(a, b); }
+	static Vec div(const Vec a, const Vec b) { return _mm512_div_pd(a, b); }
+	static Vec sqrt(const Vec a) { return _mm512_sqrt_pd(a); }
+	static Vec abs(const Vec a) { return _mm512_abs_pd(a); }
+	static Vec exponent(const Vec a) { return _mm512_getexp_pd(a); }
+	static Vec mantissa(const Vec a) { return _mm512_getmant_pd(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero); }
+	static Vec productError(const Vec a, const Vec b, const Vec p) { return _mm512_fmsub_pd(a, b, p); }
+	static Mask greater(const Vec a, const Vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+	static Vec select(const Mask m, const Vec a, const Vec b) { return _mm512_mask_blend_pd(m, b, a); }
+	static Mask all() { return 0xFF; }
+	static Mask maskAnd(const Mask a, const Mask b) { return a & b; }
+	static Mask maskAndNot(const Mask a, const Mask b) { return a & ~b; }
+	static int bits(const Mask m) { return m; }
+};
+
+/* 16 floats per __m512 */
+struct AVX512Float {
+	typedef float Scalar;
+	typedef __m512 Vec;
+	typedef __mmask16 Mask;
+	static const unsigned int lanes{ 16 };
+
+	static Vec set1(const float v) { return _mm512_set1_ps(v); }
+	static Vec load(const float* p) { return _mm512_load_ps(p); }
+	static void store(float* p, const Vec v) { _mm512_store_ps(p, v); }
+	static Vec add(const Vec a, const Vec b) { return _mm512_add_ps(a, b); }
+	static Vec sub(const Vec a, const Vec b) { return _mm512_sub_ps(a, b); }
+	static Vec mul(const Vec a, const Vec b) { return _mm512_mul_ps(a, b); }
+	static Vec abs(const Vec a) { return _mm512_abs_ps(a); }
+	static Mask greater(const Vec a, const Vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+	static Vec select(const Mask m, const Vec a, const Vec b) { return _mm512_mask_blend_ps(m, b, a); }
+	static Mask maskAnd(const Mask a, const Mask b) { return a & b; }
+	static Mask maskAndNot(const Mask a, const Mask b) { return a & ~b; }
+	static int bits(const Mask m) { return m; }
+};
+
+void MandelbrotRenderer::constructAVX512(PixelQueue queue, const PixelData data) {
+	if (trackDerivative)
+		constructSIMD<AVX512Double, true>(queue, data);
+	else
+		constructSIMD<AVX512Double>(queue, data);
+}
+
+void MandelbrotRenderer::constructDoubleDoubleAVX512(PixelQueue queue, const PixelData data) {
+	constructSIMDDoubleDouble<AVX512Double>(queue, data);
+}
+
+void MandelbrotRenderer::colorAVX512(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	colorSIMD<AVX512Double>(minWidth, maxWidth, minHeight, maxHeight, data);
+}
+
+void MandelbrotRenderer::constructFloatAVX512(PixelQueue queue, const PixelData data) {
+	if (trackDerivative)
+		constructSIMD<AVX512Float, true>(queue, data);
+	else
+		constructSIMD<AVX512Float>(queue, data);
+}
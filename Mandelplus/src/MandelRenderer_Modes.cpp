@@ -0,0 +1,302 @@
+#include "MandelRenderer.h"
+
+/* Per thread bookkeeping of the render modes that fill pixels instead of iterating them */
+struct MandelbrotRenderer::FillState {
+	unsigned int minWidth, minHeight;
+	unsigned int tileWidth;
+
+	// The tile's data, indexed like the image
+	PixelData data;
+
+	// Glitches of the perturbation modes, a filled pixel must not copy one
+	std::vector<Glitch> glitches{};
+	std::vector<unsigned char> glitched{};
+
+	unsigned int computed{ 0 };
+	unsigned int filled{ 0 };
+
+	bool isGlitched(const unsigned int x, const unsigned int y) const {
+		return !glitched.empty() && glitched[(x - minWidth) + (y - minHeight) * tileWidth];
+	}
+};
+
+/* Iterates the queued pixels with whatever construct() would use for them */
+void MandelbrotRenderer::computePixels(FillState& state, const PixelQueue queue, const unsigned int count) {
+	if (count == 0)
+		return;
+
+	state.computed += count;
+
+	if (!isPerturbedConstruct()) {
+		constructQueue(queue, state.data);
+		return;
+	}
+
+	const size_t before{ state.glitches.size() };
+	constructPerturbed(queue, state.data, state.glitches);
+
+	for (size_t g{ before }; g < state.glitches.size(); ++g) {
+		const unsigned int pixel{ state.glitches[g].pixel };
+		state.glitched[(pixel % width - state.minWidth) + (pixel / width - state.minHeight) * state.tileWidth] = 1;
+	}
+}
+
+void MandelbrotRenderer::computeRect(FillState& state, const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight) {
+	if (minWidth < maxWidth && minHeight < maxHeight)
+		computePixels(state, PixelQueue::rectangle(minWidth, maxWidth, minHeight, maxHeight), (maxWidth - minWidth) * (maxHeight - minHeight));
+}
+
+/* Hands the counters and glitches of a finished tile over to generate() */
+void MandelbrotRenderer::finishFill(FillState& state) {
+	computedPixels.fetch_add(state.computed, std::memory_order_relaxed);
+	filledPixels.fetch_add(state.filled, std::memory_order_relaxed);
+
+	if (!state.glitches.empty()) {
+		std::lock_guard<std::mutex> lock{ glitchMutex };
+		glitches.insert(glitches.end(), state.glitches.begin(), state.glitches.end());
+	}
+}
+
+/* The border of the rectangle is computed already */
+void MandelbrotRenderer::subdivide(FillState& state, const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight) {
+
+	// Nothing inside the border
+	if (maxWidth - minWidth <= 2 || maxHeight - minHeight <= 2)
+		return;
+
+	const unsigned int cornerPixel{ minWidth + minHeight * width };
+	const ManVal corner{ state.data[cornerPixel] };
+	const auto matches = [&](const unsigned int x, const unsigned int y) {
+		const ManVal& v{ state.data[x + y * width] };
+		return v.i == corner.i && v.p == corner.p && !state.isGlitched(x, y);
+	};
+
+	bool uniform{ true };
+	for (unsigned int x{ minWidth }; x < maxWidth && uniform; x++)
+		uniform = matches(x, minHeight) && matches(x, maxHeight - 1);
+	for (unsigned int y{ minHeight + 1 }; y < maxHeight - 1 && uniform; y++)
+		uniform = matches(minWidth, y) && matches(maxWidth - 1, y);
+
+	// The pixels of at least some count form a simply connected region, so short of enclosing the whole set
+	// a border of one count only encloses that count. Filled pixels copy the corner, smooth coloring is flat there
+	if (uniform) {
+		for (unsigned int y{ minHeight + 1 }; y < maxHeight - 1; y++) {
+			for (unsigned int x{ minWidth + 1 }; x < maxWidth - 1; x++) {
+				state.data.copy(x + y * width, cornerPixel);
+			}
+		}
+		state.filled += (maxWidth - minWidth - 2) * (maxHeight - minHeight - 2);
+		return;
+	}
+
+	if (maxWidth - minWidth <= subdivisionMinSize && maxHeight - minHeight <= subdivisionMinSize) {
+		computeRect(state, minWidth + 1, maxWidth - 1, minHeight + 1, maxHeight - 1);
+		return;
+	}
+
+	// Split the longer side, the dividing line becomes part of both halves' borders
+	if (maxWidth - minWidth >= maxHeight - minHeight) {
+		const unsigned int middle{ (minWidth + maxWidth) / 2 };
+		computeRect(state, middle, middle + 1, minHeight + 1, maxHeight - 1);
+		subdivide(state, minWidth, middle + 1, minHeight, maxHeight);
+		subdivide(state, middle, maxWidth, minHeight, maxHeight);
+	}
+	else {
+		const unsigned int middle{ (minHeight + maxHeight) / 2 };
+		computeRect(state, minWidth + 1, maxWidth - 1, middle, middle + 1);
+		subdivide(state, minWidth, maxWidth, minHeight, middle + 1);
+		subdivide(state, minWidth, maxWidth, middle, maxHeight);
+	}
+}
+
+void MandelbrotRenderer::constructSubdivided(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	if (minWidth >= maxWidth || minHeight >= maxHeight)
+		return;
+
+	FillState state{ minWidth, minHeight, maxWidth - minWidth, data };
+	if (isPerturbedConstruct())
+		state.glitched.assign((maxWidth - minWidth) * (maxHeight - minHeight), 0);
+
+	// Border of the whole tile
+	computeRect(state, minWidth, maxWidth, minHeight, minHeight + 1);
+	if (maxHeight - minHeight > 1)
+		computeRect(state, minWidth, maxWidth, maxHeight - 1, maxHeight);
+	computeRect(state, minWidth, minWidth + 1, minHeight + 1, maxHeight - 1);
+	if (maxWidth - minWidth > 1)
+		computeRect(state, maxWidth - 1, maxWidth, minHeight + 1, maxHeight - 1);
+
+	subdivide(state, minWidth, maxWidth, minHeight, maxHeight);
+	finishFill(state);
+}
+
+/*
+	Fractint style solid guessing: every guessStep-th pixel of the tile is computed first, then each pass halves
+	the spacing. A new pixel copies the block of the previous pass it lies in when the corners of that block,
+	and of the guessStrictness rings of blocks around it, all agree, otherwise it is computed.
+	Filaments thinner than the spacing can slip between all of those corners and get lost.
+*/
+void MandelbrotRenderer::constructGuessed(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	if (minWidth >= maxWidth || minHeight >= maxHeight)
+		return;
+
+	FillState state{ minWidth, minHeight, maxWidth - minWidth, data };
+	if (isPerturbedConstruct())
+		state.glitched.assign((maxWidth - minWidth) * (maxHeight - minHeight), 0);
+
+	// Grid lines of a pass, the last row and column always belong to it so every block is closed
+	const auto gridLines = [](const unsigned int min, const unsigned int max, const unsigned int step) {
+		std::vector<unsigned int> lines;
+		for (unsigned int v{ min }; v < max; v += step)
+			lines.push_back(v);
+		if (lines.back() != max - 1)
+			lines.push_back(max - 1);
+		return lines;
+	};
+
+	unsigned int step{ guessStep };
+	std::vector<unsigned int> columns{ gridLines(minWidth, maxWidth, step) };
+	std::vector<unsigned int> rows{ gridLines(minHeight, maxHeight, step) };
+
+	std::vector<unsigned int> pixels;
+	for (const unsigned int x : columns) {
+		for (const unsigned int y : rows)
+			pixels.push_back(x + y * width);
+	}
+	computePixels(state, PixelQueue::pixels(pixels, width), (unsigned int)pixels.size());
+
+	// Blocks between the coarse lines first to last, widened by the strictness
+	const auto agree = [&](const size_t firstColumn, const size_t lastColumn, const size_t firstRow, const size_t lastRow) {
+		const ManVal& corner{ data[columns[firstColumn] + rows[firstRow] * width] };
+		const size_t columnEnd{ std::min(lastColumn + guessStrictness + 1, columns.size()) };
+		const size_t rowEnd{ std::min(lastRow + guessStrictness + 1, rows.size()) };
+
+		for (size_t c{ firstColumn > guessStrictness ? firstColumn - guessStrictness : 0 }; c < columnEnd; c++) {
+			for (size_t r{ firstRow > guessStrictness ? firstRow - guessStrictness : 0 }; r < rowEnd; r++) {
+				const ManVal& v{ data[columns[c] + rows[r] * width] };
+				if (v.i != corner.i || v.p != corner.p || state.isGlitched(columns[c], rows[r]))
+					return false;
+			}
+		}
+		return true;
+	};
+
+	while (step > 1) {
+		step /= 2;
+		const std::vector<unsigned int> fineColumns{ gridLines(minWidth, maxWidth, step) };
+		const std::vector<unsigned int> fineRows{ gridLines(minHeight, maxHeight, step) };
+		pixels.clear();
+
+		// Whether a block, or its left or top edge, agrees. The pixels within one share the answer
+		std::vector<signed char> agreement(columns.size() * rows.size() * 3, -1);
+
+		// Guesses only read the coarse lines, so writing them right away does not affect the others.
+		// Rows outside, the pixels of a row lie next to each other in data
+		size_t row{ 0 };
+		for (const unsigned int y : fineRows) {
+			while (row + 1 < rows.size() && rows[row + 1] <= y)
+				row++;
+			const size_t nextRow{ rows[row] == y ? row : row + 1 };
+
+			size_t column{ 0 };
+			for (const unsigned int x : fineColumns) {
+				while (column + 1 < columns.size() && columns[column + 1] <= x)
+					column++;
+				const size_t nextColumn{ columns[column] == x ? column : column + 1 };
+
+				// Known from the previous pass
+				if (nextColumn == column && nextRow == row)
+					continue;
+
+				const size_t kind{ nextColumn == column ? 1u : nextRow == row ? 2u : 0u };
+				signed char& agreed{ agreement[(column * rows.size() + row) * 3 + kind] };
+				if (agreed < 0)
+					agreed = agree(column, nextColumn, row, nextRow);
+
+				if (agreed) {
+					data.copy(x + y * width, columns[column] + rows[row] * width);
+					state.filled++;
+				}
+				else {
+					pixels.push_back(x + y * width);
+				}
+			}
+		}
+		computePixels(state, PixelQueue::pixels(pixels, width), (unsigned int)pixels.size());
+
+		columns = fineColumns;
+		rows = fineRows;
+	}
+
+	finishFill(state);
+}
+
+/*
+	Computes a grid refined in passes like solid guessing, but every escaped pixel fills the pixels within the
+	quarter of its distance estimate that Koebe's theorem keeps outside the set. Those are exterior for sure,
+	yet take the iteration count of the pixel they were filled from, so the mode suits distance coloring and
+	makes the smooth coloring blocky far from the set.
+*/
+void MandelbrotRenderer::constructDiscFilled(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	if (minWidth >= maxWidth || minHeight >= maxHeight)
+		return;
+
+	const unsigned int tileWidth{ maxWidth - minWidth };
+	FillState state{ minWidth, minHeight, tileWidth, data };
+	if (isPerturbedConstruct())
+		state.glitched.assign(tileWidth * (maxHeight - minHeight), 0);
+
+	std::vector<unsigned char> done(tileWidth * (maxHeight - minHeight), 0);
+	std::vector<unsigned int> pixels;
+
+	// Distance between neighbouring pixels in the plane
+	const double spacingA{ 2 * zoom / width };
+	const double spacingB{ 2 * zoom / height };
+
+	for (unsigned int step{ guessStep }; step > 0; step /= 2) {
+		pixels.clear();
+		for (unsigned int y{ minHeight }; y < maxHeight; y += step) {
+			for (unsigned int x{ minWidth }; x < maxWidth; x += step) {
+				unsigned char& d{ done[(x - minWidth) + (y - minHeight) * tileWidth] };
+				if (!d) {
+					d = 1;
+					pixels.push_back(x + y * width);
+				}
+			}
+		}
+		computePixels(state, PixelQueue::pixels(pixels, width), (unsigned int)pixels.size());
+
+		if (step == 1)
+			break;
+
+		// A disc only has to reach as far as the pixels the following passes compute around its center
+		for (const unsigned int pixel : pixels) {
+			const ManVal center{ data[pixel] };
+			const double distance{ data.distance(pixel) };
+			const double radius{ distance / 4 };
+			const int reachA{ (int)std::min<double>(step, radius / spacingA) };
+			const int reachB{ (int)std::min<double>(step, radius / spacingB) };
+			if (reachA == 0 && reachB == 0)
+				continue;
+
+			const int x{ (int)(pixel % width) };
+			const int y{ (int)(pixel / width) };
+			for (int fy{ std::max((int)minHeight, y - reachB) }; fy <= std::min((int)maxHeight - 1, y + reachB); fy++) {
+				for (int fx{ std::max((int)minWidth, x - reachA) }; fx <= std::min((int)maxWidth - 1, x + reachA); fx++) {
+					unsigned char& d{ done[(fx - minWidth) + (fy - minHeight) * tileWidth] };
+					const double offsetA{ (fx - x) * spacingA };
+					const double offsetB{ (fy - y) * spacingB };
+					const double offset{ std::sqrt(offsetA * offsetA + offsetB * offsetB) };
+					if (d || offset > radius)
+						continue;
+
+					d = 1;
+					data[fx + fy * width] = ManVal{ center.r, center.c, center.i };
+					data.setDistance(fx + fy * width, distance - offset);
+					state.filled++;
+				}
+			}
+		}
+	}
+
+	finishFill(state);
+}
@@ -0,0 +1,93 @@
+#include "SIMD_Kernels.h"
+
+#include <emmintrin.h>
+
+/* 2 doubles per __m128d, the baseline every x64 CPU has */
+struct SSE2Double {
+	typedef double Scalar;
+	typedef __m128d Vec;
+	typedef __m128d Mask;
+	static const unsigned int lanes{ 2 };
+
+	static Vec set1(const double v) { return _mm_set1_pd(v); }
+	static Vec load(const double* p) { return _mm_load_pd(p); }
+	static void store(double* p, const Vec v) { _mm_store_pd(p, v); }
+	static void storeIndex(int* p, const Vec v) { _mm_storel_epi64((__m128i*)p, _mm_cvttpd_epi32(v)); }
+	static Vec add(const Vec a, const Vec b) { return _mm_add_pd(a, b); }
+	static Vec sub(const Vec a, const Vec b) { return _mm_sub_pd(a, b); }
+	static Vec mul(const Vec a, const Vec b) { return _mm_mul_pd(a, b); }
+	static Vec div(const Vec a, const Vec b) { return _mm_div_pd(a, b); }
+	static Vec sqrt(const Vec a) { return _mm_sqrt_pd(a); }
+	static Vec abs(const Vec a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+
+	// Biased exponent bits ORed into 2^52 turn into an exact double
+	static Vec exponent(const Vec a) {
+		const __m128i biased{ _mm_srli_epi64(_mm_castpd_si128(a), 52) };
+		const __m128d magic{ _mm_castsi128_pd(_mm_or_si128(biased, _mm_castpd_si128(_mm_set1_pd(4503599627370496.0)))) };
+		return _mm_sub_pd(magic, _mm_set1_pd(4503599627370496.0 + 1023));
+	}
+	static Vec mantissa(const Vec a) { return _mm_or_pd(_mm_and_pd(a, _mm_castsi128_pd(_mm_set1_epi64x(0x000FFFFFFFFFFFFF))), _mm_set1_pd(1)); }
+
+	// a * b - p exactly, Dekker's split since there is no FMA
+	static Vec productError(const Vec a, const Vec b, const Vec p) {
+		const Vec split{ _mm_set1_pd(134217729.0) };
+		const Vec ta{ _mm_mul_pd(split, a) };
+		const Vec aHi{ _mm_sub_pd(ta, _mm_sub_pd(ta, a)) };
+		const Vec aLo{ _mm_sub_pd(a, aHi) };
+		const Vec tb{ _mm_mul_pd(split, b) };
+		const Vec bHi{ _mm_sub_pd(tb, _mm_sub_pd(tb, b)) };
+		const Vec bLo{ _mm_sub_pd(b, bHi) };
+		const Vec err{ _mm_add_pd(_mm_add_pd(_mm_sub_pd(_mm_mul_pd(aHi, bHi), p), _mm_mul_pd(aHi, bLo)), _mm_mul_pd(aLo, bHi)) };
+		return _mm_add_pd(err, _mm_mul_pd(aLo, bLo));
+	}
+
+	static Mask greater(const Vec a, const Vec b) { return _mm_cmpgt_pd(a, b); }
+	static Vec select(const Mask m, const Vec a, const Vec b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+	static Mask all() { return _mm_castsi128_pd(_mm_set1_epi32(-1)); }
+	static Mask maskAnd(const Mask a, const Mask b) { return _mm_and_pd(a, b); }
+	static Mask maskAndNot(const Mask a, const Mask b) { return _mm_andnot_pd(b, a); }
+	static int bits(const Mask m) { return _mm_movemask_pd(m); }
+};
+
+/* 4 floats per __m128 */
+struct SSE2Float {
+	typedef float Scalar;
+	typedef __m128 Vec;
+	typedef __m128 Mask;
+	static const unsigned int lanes{ 4 };
+
+	static Vec set1(const float v) { return _mm_set1_ps(v); }
+	static Vec load(const float* p) { return _mm_load_ps(p); }
+	static void store(float* p, const Vec v) { _mm_store_ps(p, v); }
+	static Vec add(const Vec a, const Vec b) { return _mm_add_ps(a, b); }
+	static Vec sub(const Vec a, const Vec b) { return _mm_sub_ps(a, b); }
+	static Vec mul(const Vec a, const Vec b) { return _mm_mul_ps(a, b); }
+	static Vec abs(const Vec a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static Mask greater(const Vec a, const Vec b) { return _mm_cmpgt_ps(a, b); }
+	static Vec select(const Mask m, const Vec a, const Vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	static Mask maskAnd(const Mask a, const Mask b) { return _mm_and_ps(a, b); }
+	static Mask maskAndNot(const Mask a, const Mask b) { return _mm_andnot_ps(b, a); }
+	static int bits(const Mask m) { return _mm_movemask_ps(m); }
+};
+
+void MandelbrotRenderer::constructSSE2(PixelQueue queue, const PixelData data) {
+	if (trackDerivative)
+		constructSIMD<SSE2Double, true>(queue, data);
+	else
+		constructSIMD<SSE2Double>(queue, data);
+}
+
+void MandelbrotRenderer::constructDoubleDoubleSSE2(PixelQueue queue, const PixelData data) {
+	constructSIMDDoubleDouble<SSE2Double>(queue, data);
+}
+
+void MandelbrotRenderer::colorSSE2(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+	colorSIMD<SSE2Double>(minWidth, maxWidth, minHeight, maxHeight, data);
+}
+
+void MandelbrotRenderer::constructFloatSSE2(PixelQueue queue, const PixelData data) {
+	if (trackDerivative)
+		constructSIMD<SSE2Float, true>(queue, data);
+	else
+		constructSIMD<SSE2Float>(queue, data);
+}
@@ -0,0 +1,497 @@
+#pragma once
+
+#include "MandelRenderer.h"
+
+#include <limits>
+#include <type_traits>
+
+/*
+	Kernels shared by all instruction sets.
+	V wraps one vector register of doubles and has to provide:
+	Scalar, lanes, Vec, Mask, set1, load, store, storeIndex, add, sub, mul, div, sqrt, abs, exponent, mantissa,
+	productError, greater, select, all, maskAnd, maskAndNot, bits
+	Float registers only go through constructSIMD, which needs just Scalar, lanes, Vec, Mask, set1, load, store,
+	add, sub, mul, abs, greater, select, maskAnd, maskAndNot and bits.
+*/
+
+/* Natural logarithm after fdlibm's e_log.c, only positive normal inputs are exact to an ulp */
+template <class V>
+static typename V::Vec logSIMD(const typename V::Vec x) {
+	typedef typename V::Vec Vec;
+
+	// x = 2^k * m with m in [sqrt(2)/2, sqrt(2))
+	Vec k{ V::exponent(x) };
+	Vec m{ V::mantissa(x) };
+	const typename V::Mask high{ V::greater(m, V::set1(1.4142135623730951)) };
+	m = V::select(high, V::mul(m, V::set1(0.5)), m);
+	k = V::select(high, V::add(k, V::set1(1)), k);
+
+	const Vec f{ V::sub(m, V::set1(1)) };
+	const Vec s{ V::div(f, V::add(V::set1(2), f)) };
+	const Vec z{ V::mul(s, s) };
+	const Vec w{ V::mul(z, z) };
+	const Vec t1{ V::mul(w, V::add(V::set1(3.999999999940941908e-01), V::mul(w, V::add(V::set1(2.222219843214978396e-01), V::mul(w, V::set1(1.531383769920937332e-01)))))) };
+	const Vec t2{ V::mul(z, V::add(V::set1(6.666666666666735130e-01), V::mul(w, V::add(V::set1(2.857142874366239149e-01), V::mul(w, V::add(V::set1(1.818357216161805012e-01), V::mul(w, V::set1(1.479819860511658591e-01)))))))) };
+	const Vec hfsq{ V::mul(V::set1(0.5), V::mul(f, f)) };
+	const Vec r{ V::add(t2, t1) };
+
+	// k*ln2_hi - ((hfsq - (s*(hfsq+R) + k*ln2_lo)) - f)
+	const Vec inner{ V::add(V::mul(s, V::add(hfsq, r)), V::mul(k, V::set1(1.90821492927058770002e-10))) };
+	Vec result{ V::sub(V::mul(k, V::set1(6.93147180369123816490e-01)), V::sub(V::sub(hfsq, inner), f)) };
+
+	// Zero, negative and NaN inputs end up as colorI 0 either way, infinity stays infinity
+	result = V::select(V::greater(x, V::set1(0)), result, V::set1(std::numeric_limits<double>::quiet_NaN()));
+	result = V::select(V::greater(x, V::set1(std::numeric_limits<double>::max())), x, result);
+	return result;
+}
+
+/*
+	Every lane runs exactly the same operations as getMandelbrotValue, or getMandelbrotValueFloat for float
+	registers, so the results are bit identical.
+	Instead of waiting for the slowest pixel of a vector, a lane whose pixel escaped, cycles or ran out of
+	iterations is written back and refilled with the next pixel of the queue right away.
+	Derivative additionally tracks dz/dc for the distance estimate.
+*/
+template <class V, bool Derivative>
+void MandelbrotRenderer::constructSIMD(PixelQueue queue, const PixelData data) {
+
+	typedef typename V::Scalar Scalar;
+
+	if (maxIterations == 0) {
+		unsigned int x, y, interior{ 0 };
+		double distance{ 0 };
+		while (queue.pop(x, y))
+			data[x + y * width] = std::is_same<Scalar, float>::value ? getMandelbrotValueFloat(x, y, interior, distance) : getMandelbrotValue(x, y, interior, distance);
+		interiorPixels.fetch_add(interior, std::memory_order_relaxed);
+		return;
+	}
+
+	const unsigned int lanes{ V::lanes };
+
+	// Lane state, only spilled to memory when lanes are refilled
+	alignas(64) Scalar initialA[V::lanes];
+	alignas(64) Scalar initialB[V::lanes];
+	alignas(64) Scalar laneA[V::lanes];
+	alignas(64) Scalar laneB[V::lanes];
+	alignas(64) Scalar laneN[V::lanes];
+	alignas(64) Scalar live[V::lanes];
+	alignas(64) Scalar laneDA[V::lanes];
+	alignas(64) Scalar laneDB[V::lanes];
+	unsigned int pixel[V::lanes];
+
+	// Orbit point saved for cycle detection, when it was saved and the iteration count of the next save
+	alignas(64) Scalar savedA[V::lanes];
+	alignas(64) Scalar savedB[V::lanes];
+	alignas(64) Scalar savedN[V::lanes];
+	alignas(64) Scalar checkpoint[V::lanes];
+
+	// Without cycle detection nothing is ever closer than 0 and the first checkpoint is the last iteration
+	const Scalar firstCheckpoint{ periodicityChecking ? (Scalar)1 : (Scalar)maxIterations };
+
+	// Pops the next pixel that needs iterating, interior ones are written right away
+	unsigned int interior{ 0 };
+	const auto nextPixel = [&](unsigned int& px, unsigned int& py) {
+		while (queue.pop(px, py)) {
+			const unsigned int period{ interiorPeriod(map(px, 0, width, -zoom, zoom) + dx, map(py, 0, height, -zoom, zoom) + dy) };
+			if (period == 0)
+				return true;
+
+			data[px + py * width] = ManVal{ 0, 0, maxIterations, period };
+			interior++;
+		}
+		return false;
+	};
+
+	for (unsigned int l{ 0 }; l < lanes; l++) {
+		unsigned int px{ 0 }, py{ 0 };
+		const bool filled{ nextPixel(px, py) };
+
+		// Map pixel position between minR and maxR, empty lanes idle at 0
+		initialA[l] = filled ? (Scalar)(map(px, 0, width, -zoom, zoom) + dx) : 0;
+		initialB[l] = filled ? (Scalar)(map(py, 0, height, -zoom, zoom) + dy) : 0;
+		laneN[l] = 0;
+		live[l] = filled ? 1 : 0;
+		pixel[l] = px + py * width;
+		laneDA[l] = 1;
+		laneDB[l] = 0;
+
+		savedA[l] = initialA[l];
+		savedB[l] = initialB[l];
+		savedN[l] = 0;
+		checkpoint[l] = firstCheckpoint;
+	}
+
+	const typename V::Vec two{ V::set1(2) };
+	const typename V::Vec one{ V::set1(1) };
+	const typename V::Vec zero{ V::set1(0) };
+	const typename V::Vec iterations{ V::set1((Scalar)maxIterations) };
+	const typename V::Vec bailout{ V::set1((Scalar)bailoutSquared) };
+	const typename V::Vec tolerance{ V::set1(!periodicityChecking ? 0 : std::is_same<Scalar, float>::value ? periodToleranceFloat : (Scalar)periodTolerance) };
+
+	typename V::Vec ca{ V::load(initialA) };
+	typename V::Vec cb{ V::load(initialB) };
+	typename V::Vec a{ ca };
+	typename V::Vec b{ cb };
+	typename V::Vec aa{ V::mul(a, a) };
+	typename V::Vec bb{ V::mul(b, b) };
+	typename V::Vec n{ V::load(laneN) };
+	typename V::Vec da{ V::load(laneDA) };
+	typename V::Vec db{ V::load(laneDB) };
+	typename V::Vec sa{ V::load(savedA) };
+	typename V::Vec sb{ V::load(savedB) };
+	typename V::Vec sn{ V::load(savedN) };
+	typename V::Vec check{ V::load(checkpoint) };
+	typename V::Mask active{ V::greater(V::load(live), zero) };
+
+	while (V::bits(active)) {
+		if (Derivative) {
+			const typename V::Vec newDa{ V::add(V::mul(two, V::sub(V::mul(a, da), V::mul(b, db))), one) };
+			db = V::mul(two, V::add(V::mul(a, db), V::mul(b, da)));
+			da = newDa;
+		}
+
+		// Apply mandelbrot formula
+		const typename V::Vec newA{ V::sub(aa, bb) };
+		const typename V::Vec newB{ V::mul(V::mul(two, a), b) };
+
+		a = V::add(ca, newA);
+		b = V::add(cb, newB);
+
+		// If it gets towards infinity, the squares are reused by the next iteration
+		aa = V::mul(a, a);
+		bb = V::mul(b, b);
+		const typename V::Mask escaped{ V::greater(V::add(aa, bb), bailout) };
+
+		// Back at the saved point, so it cycles forever
+		const typename V::Vec distA{ V::sub(a, sa) };
+		const typename V::Vec distB{ V::sub(b, sb) };
+		const typename V::Mask periodic{ V::greater(tolerance, V::add(V::mul(distA, distA), V::mul(distB, distB))) };
+
+		// Checkpoints are capped at maxIterations, so running out of iterations stops at one as well
+		const typename V::Vec next{ V::add(n, one) };
+		const typename V::Mask running{ V::maskAndNot(V::maskAndNot(V::greater(check, next), escaped), periodic) };
+		int doneBits{ V::bits(V::maskAndNot(active, running)) };
+
+		n = next;
+
+		if (doneBits == 0)
+			continue;
+
+		// Lanes that only reached a checkpoint save their orbit in the registers and keep going
+		const typename V::Mask save{ V::maskAnd(V::maskAndNot(active, running), V::maskAndNot(V::maskAndNot(V::greater(iterations, next), escaped), periodic)) };
+		const int saveBits{ V::bits(save) };
+		if (saveBits != 0) {
+			const typename V::Vec doubled{ V::add(check, check) };
+			sa = V::select(save, a, sa);
+			sb = V::select(save, b, sb);
+			sn = V::select(save, next, sn);
+			check = V::select(save, V::select(V::greater(doubled, iterations), iterations, doubled), check);
+			doneBits &= ~saveBits;
+
+			if (doneBits == 0)
+				continue;
+		}
+
+		// Write back finished lanes and pull the next pixels into them
+		const int escapedBits{ V::bits(escaped) };
+		const int periodicBits{ V::bits(periodic) };
+		V::store(laneA, a);
+		V::store(laneB, b);
+		V::store(laneN, n);
+		if (Derivative) {
+			V::store(laneDA, da);
+			V::store(laneDB, db);
+		}
+		V::store(savedA, sa);
+		V::store(savedB, sb);
+		V::store(savedN, sn);
+		V::store(checkpoint, check);
+
+		for (unsigned int l{ 0 }; l < lanes; l++) {
+			if (!(doneBits & (1 << l)))
+				continue;
+
+			// Escaped lanes report the iteration they escaped in
+			if (escapedBits & (1 << l)) {
+				data[pixel[l]] = ManVal{ laneA[l], laneB[l], (unsigned int)laneN[l] - 1 };
+				if (Derivative)
+					data.setDistance(pixel[l], distanceEstimate(laneA[l], laneB[l], laneDA[l], laneDB[l], initialA[l], initialB[l]));
+			}
+			else if (periodicBits & (1 << l))
+				data[pixel[l]] = ManVal{ laneA[l], laneB[l], maxIterations, (unsigned int)(laneN[l] - savedN[l]) };
+			else
+				data[pixel[l]] = ManVal{ laneA[l], laneB[l], maxIterations };
+
+			unsigned int px, py;
+			if (nextPixel(px, py)) {
+				initialA[l] = (Scalar)(map(px, 0, width, -zoom, zoom) + dx);
+				initialB[l] = (Scalar)(map(py, 0, height, -zoom, zoom) + dy);
+				pixel[l] = px + py * width;
+			}
+			else {
+				initialA[l] = 0;
+				initialB[l] = 0;
+				live[l] = 0;
+			}
+			laneA[l] = initialA[l];
+			laneB[l] = initialB[l];
+			laneN[l] = 0;
+			laneDA[l] = 1;
+			laneDB[l] = 0;
+
+			savedA[l] = initialA[l];
+			savedB[l] = initialB[l];
+			savedN[l] = 0;
+			checkpoint[l] = firstCheckpoint;
+		}
+
+		ca = V::load(initialA);
+		cb = V::load(initialB);
+		a = V::load(laneA);
+		b = V::load(laneB);
+		aa = V::mul(a, a);
+		bb = V::mul(b, b);
+		n = V::load(laneN);
+		if (Derivative) {
+			da = V::load(laneDA);
+			db = V::load(laneDB);
+		}
+		sa = V::load(savedA);
+		sb = V::load(savedB);
+		sn = V::load(savedN);
+		check = V::load(checkpoint);
+		active = V::greater(V::load(live), zero);
+	}
+
+	interiorPixels.fetch_add(interior, std::memory_order_relaxed);
+}
+
+/* DoubleDouble.h on whole vectors. Passed by reference, 32 bit MSVC cannot pass over-aligned structs by value (C2719) */
+template <class V>
+struct DoubleDoubleSIMD {
+	typename V::Vec hi, lo;
+};
+
+template <class V>
+static inline typename V::Vec twoSumSIMD(const typename V::Vec a, const typename V::Vec b, typename V::Vec& e) {
+	const typename V::Vec s{ V::add(a, b) };
+	const typename V::Vec bb{ V::sub(s, a) };
+	e = V::add(V::sub(a, V::sub(s, bb)), V::sub(b, bb));
+	return s;
+}
+
+template <class V>
+static inline typename V::Vec quickTwoSumSIMD(const typename V::Vec a, const typename V::Vec b, typename V::Vec& e) {
+	const typename V::Vec s{ V::add(a, b) };
+	e = V::sub(b, V::sub(s, a));
+	return s;
+}
+
+template <class V>
+static inline DoubleDoubleSIMD<V> ddAddSIMD(const DoubleDoubleSIMD<V>& a, const DoubleDoubleSIMD<V>& b) {
+	typename V::Vec e, f;
+	typename V::Vec s{ twoSumSIMD<V>(a.hi, b.hi, e) };
+	const typename V::Vec t{ twoSumSIMD<V>(a.lo, b.lo, f) };
+	e = V::add(e, t);
+	s = quickTwoSumSIMD<V>(s, e, e);
+	e = V::add(e, f);
+	s = quickTwoSumSIMD<V>(s, e, e);
+	return DoubleDoubleSIMD<V>{ s, e };
+}
+
+template <class V>
+static inline DoubleDoubleSIMD<V> ddSubSIMD(const DoubleDoubleSIMD<V>& a, const DoubleDoubleSIMD<V>& b) {
+	const typename V::Vec zero{ V::set1(0) };
+	return ddAddSIMD<V>(a, DoubleDoubleSIMD<V>{ V::sub(zero, b.hi), V::sub(zero, b.lo) });
+}
+
+template <class V>
+static inline DoubleDoubleSIMD<V> ddMulSIMD(const DoubleDoubleSIMD<V>& a, const DoubleDoubleSIMD<V>& b) {
+	const typename V::Vec p{ V::mul(a.hi, b.hi) };
+	typename V::Vec e{ V::productError(a.hi, b.hi, p) };
+	e = V::add(e, V::add(V::mul(a.hi, b.lo), V::mul(a.lo, b.hi)));
+	const typename V::Vec s{ quickTwoSumSIMD<V>(p, e, e) };
+	return DoubleDoubleSIMD<V>{ s, e };
+}
+
+template <class V>
+static inline DoubleDoubleSIMD<V> ddSqrSIMD(const DoubleDoubleSIMD<V>& a) {
+	const typename V::Vec p{ V::mul(a.hi, a.hi) };
+	typename V::Vec e{ V::productError(a.hi, a.hi, p) };
+	e = V::add(e, V::mul(V::mul(V::set1(2), a.hi), a.lo));
+	const typename V::Vec s{ quickTwoSumSIMD<V>(p, e, e) };
+	return DoubleDoubleSIMD<V>{ s, e };
+}
+
+/* Lane refilling like constructSIMD, every lane runs getMandelbrotValueDD */
+template <class V>
+void MandelbrotRenderer::constructSIMDDoubleDouble(PixelQueue queue, const PixelData data) {
+
+	if (maxIterations == 0) {
+		unsigned int x, y;
+		while (queue.pop(x, y))
+			data[x + y * width] = getMandelbrotValueDD(x, y);
+		return;
+	}
+
+	const unsigned int lanes{ V::lanes };
+
+	// Lane state, only spilled to memory when lanes are refilled
+	alignas(64) double initialA[2][V::lanes];
+	alignas(64) double initialB[2][V::lanes];
+	alignas(64) double laneA[2][V::lanes];
+	alignas(64) double laneB[2][V::lanes];
+	alignas(64) double laneN[V::lanes];
+	alignas(64) double live[V::lanes];
+	unsigned int pixel[V::lanes];
+
+	for (unsigned int l{ 0 }; l < lanes; l++) {
+		unsigned int px{ 0 }, py{ 0 };
+		const bool filled{ queue.pop(px, py) };
+
+		const DoubleDouble ca{ filled ? ddAdd(centerX, map(px, 0, width, -zoom, zoom)) : DoubleDouble{ 0, 0 } };
+		const DoubleDouble cb{ filled ? ddAdd(centerY, map(py, 0, height, -zoom, zoom)) : DoubleDouble{ 0, 0 } };
+		initialA[0][l] = ca.hi;
+		initialA[1][l] = ca.lo;
+		initialB[0][l] = cb.hi;
+		initialB[1][l] = cb.lo;
+		laneN[l] = 0;
+		live[l] = filled ? 1 : 0;
+		pixel[l] = px + py * width;
+	}
+
+	const typename V::Vec two{ V::set1(2) };
+	const typename V::Vec one{ V::set1(1) };
+	const typename V::Vec zero{ V::set1(0) };
+	const typename V::Vec iterations{ V::set1(maxIterations) };
+	const typename V::Vec bailout{ V::set1(bailoutSquared) };
+
+	DoubleDoubleSIMD<V> ca{ V::load(initialA[0]), V::load(initialA[1]) };
+	DoubleDoubleSIMD<V> cb{ V::load(initialB[0]), V::load(initialB[1]) };
+	DoubleDoubleSIMD<V> a{ ca };
+	DoubleDoubleSIMD<V> b{ cb };
+	typename V::Vec n{ V::load(laneN) };
+	typename V::Mask active{ V::greater(V::load(live), zero) };
+
+	while (V::bits(active)) {
+		// Apply mandelbrot formula
+		const DoubleDoubleSIMD<V> newA{ ddSubSIMD<V>(ddSqrSIMD<V>(a), ddSqrSIMD<V>(b)) };
+		const DoubleDoubleSIMD<V> ab{ ddMulSIMD<V>(a, b) };
+		const DoubleDoubleSIMD<V> newB{ V::mul(two, ab.hi), V::mul(two, ab.lo) };
+
+		a = ddAddSIMD<V>(ca, newA);
+		b = ddAddSIMD<V>(cb, newB);
+
+		// If it gets towards infinity
+		const typename V::Mask escaped{ V::greater(V::add(V::mul(a.hi, a.hi), V::mul(b.hi, b.hi)), bailout) };
+		const typename V::Vec next{ V::add(n, one) };
+		const typename V::Mask running{ V::maskAndNot(V::greater(iterations, next), escaped) };
+		const int doneBits{ V::bits(V::maskAndNot(active, running)) };
+
+		n = next;
+
+		if (doneBits == 0)
+			continue;
+
+		// Write back finished lanes and pull the next pixels into them
+		const int escapedBits{ V::bits(escaped) };
+		V::store(laneA[0], a.hi);
+		V::store(laneA[1], a.lo);
+		V::store(laneB[0], b.hi);
+		V::store(laneB[1], b.lo);
+		V::store(laneN, n);
+
+		for (unsigned int l{ 0 }; l < lanes; l++) {
+			if (!(doneBits & (1 << l)))
+				continue;
+
+			const unsigned int i{ (escapedBits & (1 << l)) ? (unsigned int)laneN[l] - 1 : maxIterations };
+			data[pixel[l]] = ManVal{ laneA[0][l], laneB[0][l], i };
+
+			unsigned int px, py;
+			DoubleDouble nextA{ 0, 0 };
+			DoubleDouble nextB{ 0, 0 };
+			if (queue.pop(px, py)) {
+				nextA = ddAdd(centerX, map(px, 0, width, -zoom, zoom));
+				nextB = ddAdd(centerY, map(py, 0, height, -zoom, zoom));
+				pixel[l] = px + py * width;
+			}
+			else {
+				live[l] = 0;
+			}
+			initialA[0][l] = laneA[0][l] = nextA.hi;
+			initialA[1][l] = laneA[1][l] = nextA.lo;
+			initialB[0][l] = laneB[0][l] = nextB.hi;
+			initialB[1][l] = laneB[1][l] = nextB.lo;
+			laneN[l] = 0;
+		}
+
+		ca = DoubleDoubleSIMD<V>{ V::load(initialA[0]), V::load(initialA[1]) };
+		cb = DoubleDoubleSIMD<V>{ V::load(initialB[0]), V::load(initialB[1]) };
+		a = DoubleDoubleSIMD<V>{ V::load(laneA[0]), V::load(laneA[1]) };
+		b = DoubleDoubleSIMD<V>{ V::load(laneB[0]), V::load(laneB[1]) };
+		n = V::load(laneN);
+		active = V::greater(V::load(live), zero);
+	}
+}
+
+template <class V>
+void MandelbrotRenderer::colorSIMD(const unsigned int minWidth, const unsigned int maxWidth, const unsigned int minHeight, const unsigned int maxHeight, const PixelData data) {
+
+	const unsigned int lanes{ V::lanes };
+
+	alignas(64) double r[V::lanes];
+	alignas(64) double c[V::lanes];
+	alignas(64) double iterations[V::lanes];
+	alignas(64) int colorI[V::lanes];
+
+	const typename V::Vec oneOverLog2{ V::set1(ONE_OVER_LOG2) };
+	const typename V::Vec scale{ V::set1(smoothingScale) };
+
+	// Row by row, data and rgbBuffer are laid out that way
+	for (unsigned int y{ minHeight }; y < maxHeight; y++) {
+		unsigned int x{ minWidth };
+
+		for (; x + lanes <= maxWidth; x += lanes) {
+
+			const unsigned int dataIndex{ (x + y * width) };
+
+			for (unsigned int l{ 0 }; l < lanes; l++) {
+				const ManVal& v{ data[dataIndex + l] };
+				r[l] = v.r;
+				c[l] = v.c;
+				iterations[l] = v.i;
+			}
+
+			// Same formula as getColor
+			const typename V::Vec vr{ V::load(r) };
+			const typename V::Vec vc{ V::load(c) };
+			const typename V::Vec size{ V::sqrt(V::add(V::mul(vr, vr), V::mul(vc, vc))) };
+			const typename V::Vec smoothed{ V::mul(logSIMD<V>(V::mul(V::mul(logSIMD<V>(size), oneOverLog2), scale)), oneOverLog2) };
+			const typename V::Vec index{ V::mul(V::sqrt(V::sub(V::add(V::load(iterations), V::set1(1)), smoothed)), V::set1(256)) };
+			V::storeIndex(colorI, index);
+
+			for (unsigned int l{ 0 }; l < lanes; l++) {
+				// Out of range conversions yield INT_MIN, which getColor maps to 0 as well
+				const Color col{ palette[colorI[l] & 511] };
+				const unsigned int i{ (dataIndex + l) * 3 };
+				rgbBuffer[i + 0] = col.r;
+				rgbBuffer[i + 1] = col.g;
+				rgbBuffer[i + 2] = col.b;
+			}
+		}
+
+		// End of the row that does not fill a whole vector
+		for (; x < maxWidth; x++) {
+			const unsigned int dataIndex{ (x + y * width) };
+			const unsigned int i{ dataIndex * 3 };
+
+			ManVal v{ data[dataIndex] };
+			Color col{ getColor(v.i,v.r,v.c) };
+
+			rgbBuffer[i + 0] = col.r;
+			rgbBuffer[i + 1] = col.g;
+			rgbBuffer[i + 2] = col.b;
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#include "SelfTest.h"
+#include "MandelRenderer.h"
+
+namespace {
+
+struct View {
+	const char* name;
+	double dx, dy, zoom;
+	unsigned int iterations;
+};
+
+/* Odd sizes leave lanes empty at the end of every tile, the views cover escaping, interior and deep pixels */
+const unsigned int testWidth{ 97 };
+const unsigned int testHeight{ 61 };
+
+const View views[]{
+	{ "full set", -0.75, 0, 1.5, 500 },
+	{ "seahorse valley", -0.75, 0.1, 0.05, 1000 },
+	{ "cloverleaf", -0.04524074130409, 0.9868162207157838, 5e-12, 2000 }
+};
+
+bool sameValue(const ManVal& a, const ManVal& b) {
+	return a.r == b.r && a.c == b.c && a.i == b.i && a.p == b.p;
+}
+
+}
+
+bool checkKernels() {
+	const std::shared_ptr<ThreadPool> pool{ std::make_shared<ThreadPool>() };
+	const Kernel kernels[]{ Kernel::SSE2, Kernel::AVX2, Kernel::AVX512 };
+	const Precision precisions[]{ Precision::Float, Precision::Double, Precision::DoubleDouble };
+
+	for (const View& view : views) {
+		for (const Precision precision : precisions) {
+			for (const bool distance : { false, true }) {
+
+				MandelbrotRenderer reference{ testWidth, testHeight, view.iterations, view.zoom, view.dx, view.dy };
+				reference.setThreadPool(pool);
+				reference.setPrecision(precision);
+				reference.setDistanceEstimation(distance);
+				reference.setKernel(Kernel::Scalar);
+				reference.generate();
+				reference.color();
+
+				ManVal* expectedData{ reference.cloneData() };
+				double* expectedDistances{ reference.cloneDistanceData() };
+				char* expectedRGB{ reference.cloneRGB() };
+				bool passed{ true };
+
+				for (const Kernel kernel : kernels) {
+					MandelbrotRenderer renderer{ testWidth, testHeight, view.iterations, view.zoom, view.dx, view.dy };
+					renderer.setThreadPool(pool);
+					renderer.setPrecision(precision);
+					renderer.setDistanceEstimation(distance);
+					renderer.setKernel(kernel);
+
+					// Not supported by this CPU
+					if (renderer.getKernel() != kernel)
+						continue;
+
+					renderer.generate();
+					renderer.color();
+
+					ManVal* data{ renderer.cloneData() };
+					double* distances{ renderer.cloneDistanceData() };
+					char* rgb{ renderer.cloneRGB() };
+
+					for (unsigned int i{ 0 }; i < renderer.getNumPixels() && passed; ++i) {
+						if (!sameValue(data[i], expectedData[i]) || (distance && distances[i] != expectedDistances[i])
+							|| std::memcmp(rgb + i * 3, expectedRGB + i * 3, 3) != 0) {
+							std::cout << "Kernel check failed: " << renderer.getKernelName() << " " << renderer.getPrecisionName()
+								<< (distance ? " with distance estimation" : "") << " on the " << view.name
+								<< " at pixel " << i % testWidth << ", " << i / testWidth << std::endl;
+							passed = false;
+						}
+					}
+
+					delete[] data;
+					delete[] distances;
+					delete[] rgb;
+				}
+
+				delete[] expectedData;
+				delete[] expectedDistances;
+				delete[] expectedRGB;
+
+				if (!passed)
+					return false;
+			}
+		}
+	}
+
+	std::cout << "Kernel check passed" << std::endl;
+	return true;
+}
+
+bool checkTileGrid() {
+	// Primes, single rows and columns, images smaller than one tile and exact multiples of it
+	const unsigned int sizes[]{ 1, 2, 3, 7, 13, 61, 64, 65, 97, 128, 509 };
+	const unsigned int tileSizes[]{ 1, 2, 3, 7, 16, 63, 64, 65, 100, 128, 1000 };
+
+	std::vector<unsigned char> counts;
+
+	for (const unsigned int width : sizes) {
+		for (const unsigned int height : sizes) {
+			for (const unsigned int tileSize : tileSizes) {
+				const TileGrid grid{ width, height, tileSize };
+				counts.assign(width * height, 0);
+				bool passed{ true };
+
+				for (unsigned int tile{ 0 }; tile < grid.count(); tile++) {
+					unsigned int minWidth, maxWidth, minHeight, maxHeight;
+					grid.bounds(tile, minWidth, maxWidth, minHeight, maxHeight);
+					if (minWidth >= maxWidth || minHeight >= maxHeight || maxWidth > width || maxHeight > height) {
+						passed = false;
+						break;
+					}
+
+					for (unsigned int y{ minHeight }; y < maxHeight; y++) {
+						for (unsigned int x{ minWidth }; x < maxWidth; x++)
+							counts[x + y * width]++;
+					}
+				}
+
+				for (unsigned int i{ 0 }; i < width * height && passed; i++)
+					passed = counts[i] == 1;
+
+				if (!passed) {
+					std::cout << "Tile grid check failed: " << width << "x" << height << " in tiles of " << tileSize << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+
+	std::cout << "Tile grid check passed" << std::endl;
+	return true;
+}
+
+bool runSelfTest() {
+	return checkTileGrid() && checkKernels();
+}
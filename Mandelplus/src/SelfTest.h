@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+	Checks run by "Mandelplus --selftest" instead of rendering the preset. Each one prints what did not match
+	and returns false on the first failure.
+*/
+
+/* Every vectorized kernel the CPU supports against Kernel::Scalar, ManVal and RGB have to be bit-identical */
+bool checkKernels();
+
+/* Every pixel in exactly one non-empty tile of TileGrid, for sizes that do and do not divide into tiles */
+bool checkTileGrid();
+
+/* Runs all checks, true if every one passed */
+bool runSelfTest();
@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int numThreads) {
+
+	// hardware_concurrency may not know
+	numThreads = numThreads == 0 ? 1 : numThreads;
+
+	for (unsigned int i{ 0 }; i < numThreads; ++i)
+		queues.push_back(std::unique_ptr<Queue>{ new Queue });
+
+	// The last deque belongs to the threads calling run()
+	for (unsigned int i{ 0 }; i + 1 < numThreads; ++i)
+		workers.push_back(std::thread(&ThreadPool::work, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock{ sleepMutex };
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+/* Newest task of the own deque, otherwise the oldest of the first other deque that has one */
+bool ThreadPool::pop(const unsigned int own, std::function<void()>& task) {
+	const unsigned int numQueues{ (unsigned int)queues.size() };
+
+	for (unsigned int i{ 0 }; i < numQueues; ++i) {
+		Queue& queue{ *queues[(own + i) % numQueues] };
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		if (queue.tasks.empty())
+			continue;
+
+		if (i == 0) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		pending--;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::work(const unsigned int index) {
+	std::function<void()> task;
+
+	while (true) {
+		if (pop(index, task)) {
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{ sleepMutex };
+		wake.wait(lock, [this] { return stopping || pending > 0; });
+		if (stopping)
+			return;
+	}
+}
+
+void ThreadPool::run(const unsigned int count, const std::function<void(unsigned int)>& task) {
+	if (count == 0)
+		return;
+
+	std::atomic<unsigned int> remaining{ count };
+	std::mutex doneMutex;
+	std::condition_variable done;
+
+	// Counted down under the lock, so run() cannot return and take the mutex with it while a worker still holds it
+	const auto finish = [&] {
+		std::lock_guard<std::mutex> lock{ doneMutex };
+		if (--remaining == 0)
+			done.notify_all();
+	};
+
+	// Round robin, so every worker starts on its own share and only steals once that is gone
+	const unsigned int numQueues{ (unsigned int)queues.size() };
+	const unsigned int first{ nextQueue.fetch_add(count) };
+	for (unsigned int i{ 0 }; i < count; ++i) {
+		Queue& queue{ *queues[(first + i) % numQueues] };
+		std::lock_guard<std::mutex> lock{ queue.mutex };
+		queue.tasks.push_back([&task, &finish, i] {
+			task(i);
+			finish();
+		});
+		pending++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ sleepMutex };
+	}
+	wake.notify_all();
+
+	// Work along, the tasks taken here may belong to other batches as well
+	std::function<void()> own;
+	while (remaining > 0 && pop(numQueues - 1, own))
+		own();
+
+	std::unique_lock<std::mutex> lock{ doneMutex };
+	done.wait(lock, [&] { return remaining == 0; });
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	Persistent worker threads, each with its own deque of tasks. A worker takes the newest task of its own deque
+	and steals the oldest of the others' once it runs dry, so uneven tasks balance out without a shared queue
+	every thread contends for. The thread calling run() works along until its batch is done, a pool of one
+	thread has no workers at all.
+*/
+class ThreadPool {
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<Queue>> queues;
+
+	/* Tasks queued and not yet taken, the workers sleep while there are none */
+	std::atomic<unsigned int> pending{ 0 };
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	bool stopping{ false };
+
+	/* Spreads the tasks of consecutive run() calls over all deques */
+	std::atomic<unsigned int> nextQueue{ 0 };
+
+	bool pop(const unsigned int own, std::function<void()>& task);
+	void work(const unsigned int index);
+
+public:
+	/* Threads including the one calling run(), hardware_concurrency by default */
+	explicit ThreadPool(unsigned int numThreads = std::thread::hardware_concurrency());
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool();
+
+	unsigned int size() const {
+		return (unsigned int)workers.size() + 1;
+	}
+
+	/* Runs task(0) to task(count - 1) and returns once all of them finished */
+	void run(const unsigned int count, const std::function<void(unsigned int)>& task);
+};
@@ -1,7 +1,75 @@
 #include "MandelRenderer.h"
+#include "SelfTest.h"
+#include <chrono>
+#include <initializer_list>
+
+/* Seconds the call takes */
+template <typename F>
+static double timed(F f) {
+	const auto start{ std::chrono::steady_clock::now() };
+	f();
+	const std::chrono::duration<double> elapsed{ std::chrono::steady_clock::now() - start };
+	return elapsed.count();
+}
+
+/* generate() of one view in each of the precisions, with the pixels whose iteration count differs from the first */
+static void comparePrecisions(const char* name, const unsigned int size, const unsigned int iterations, const double zoom, const double dx, const double dy,
+	const std::initializer_list<Precision> precisions) {
+	std::cout << name << " " << size << "x" << size << ", " << iterations << " iterations" << std::endl;
+
+	unsigned int* reference{ nullptr };
+	for (const Precision precision : precisions) {
+		MandelbrotRenderer renderer{ size, size, iterations, zoom, dx, dy };
+		renderer.setPrecision(precision);
+		const double elapsed{ timed([&] { renderer.generate(); }) };
+
+		unsigned int* counts{ renderer.cloneIterationData() };
+		unsigned int differing{ 0 };
+		if (reference == nullptr) {
+			reference = counts;
+		}
+		else {
+			for (unsigned int i{ 0 }; i < renderer.getNumPixels(); ++i)
+				differing += counts[i] != reference[i];
+			delete[] counts;
+		}
+
+		std::cout << "  " << renderer.getPrecisionName() << " " << elapsed << " s, " << differing << " pixels differ" << std::endl;
+	}
+
+	delete[] reference;
+}
+
+/* Times the steps of the cloverleaf render separately, nothing is shown or exported */
+static void runBenchmark() {
+	const unsigned int size{ 2000 };
+	MandelbrotRenderer renderer{ size, size, 2000, 5.0E-12, -0.04524074130409, 0.9868162207157838 };
+	std::cout << "Cloverleaf " << size << "x" << size << ", " << renderer.getKernelName() << " kernels" << std::endl;
+
+	const double generate{ timed([&] { renderer.generate(); }) };
+	std::cout << "generate() " << generate << " s with " << renderer.getPrecisionName() << " precision" << std::endl;
+	std::cout << "color()    " << timed([&] { renderer.color(); }) << " s" << std::endl;
+
+	renderer.setKeepData(false);
+	std::cout << "render()   " << timed([&] { renderer.render(); }) << " s without keeping the data" << std::endl;
+
+	// Twice the lanes per register for float, at the cost of some counts near the boundary
+	comparePrecisions("Whole set", 1000, 1000, 2.0, 0, 0, { Precision::Double, Precision::Float });
+
+	// Deep in a minibrot on the antenna, nearly every pixel runs all iterations
+	comparePrecisions("Antenna minibrot", 32, 200000, 1.0E-25, -1.77, 0, { Precision::Perturbation, Precision::BLA });
+}
 
 int main(int argc, char* argv[]){
 
+	if (argc > 1 && std::string{ argv[1] } == "--selftest")
+		return runSelfTest() ? 0 : 1;
+
+	if (argc > 1 && std::string{ argv[1] } == "--bench") {
+		runBenchmark();
+		return 0;
+	}
+
 	/*  cloverleaf */
 	const double dx = -0.04524074130409;
 	const double dy = 0.9868162207157838;
@@ -10,10 +78,14 @@ int main(int argc, char* argv[]){
 	const unsigned int size = 10000;
 
 	MandelbrotRenderer* r1{ new MandelbrotRenderer{size, size, iterations, zoom, dx,dy } };
-	std::cout << "Generating image" << std::endl;
-	r1->generate();
-	std::cout << "Coloring image" << std::endl;
-	r1->color();
+	std::cout << "Using " << r1->getKernelName() << " kernels" << std::endl;
+	// Only the image is wanted, the 24 bytes per pixel of iteration data are not kept
+	r1->setKeepData(false);
+
+	std::cout << "Rendering image" << std::endl;
+	const double elapsed{ timed([&] { r1->render(); }) };
+	std::cout << "Rendered in " << elapsed << " s with " << r1->getPrecisionName() << " precision" << std::endl;
+
 	r1->exportPPM();
 	r1->show();
 